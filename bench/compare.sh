@@ -0,0 +1,11 @@
+#!/bin/sh
+# Compares the adaptive scheduler with the fixed ones on the mixed benchmark traces.
+# Prints average turnaround time and max wait time of every algorithm for every trace.
+# Run from the top directory after make: sh bench/compare.sh
+for trace in bench/mix*.txt; do
+	printf "%-16s" "$(basename $trace)"
+	for algo in j s c a; do
+		./iosched -s$algo $trace | awk -v algo=$algo '/^SUM:/ { printf "  %s %8s %5s", algo, $4, $6 }'
+	done
+	printf "\n"
+done
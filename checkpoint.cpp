@@ -0,0 +1,374 @@
+/*
+	Module Name: checkpoint.cpp
+	Description: Saves the full state of a running simulation to a binary checkpoint file and restores it,
+		so that a long simulation can be resumed after it is interrupted. The results of completed requests
+		and the lines printed during the run are appended to a log beside the checkpoint as they accumulate,
+		so a checkpoint itself only holds the requests still pending and its cost does not grow with the
+		length of the run.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <list>
+#include <vector>
+#include <string>
+#include "data_structures.h"
+
+/*************************** imported from main.cpp ***************************/
+extern int cache_capacity, cache_high_watermark, cache_low_watermark;
+extern bool ssd;
+extern int ssd_channels, ssd_read_time, ssd_write_time;
+extern bool ssd_channel_aware;
+extern DiskGeometry *geometry;
+extern int anticipation_window, anticipation_distance;
+extern int replay_from, replay_to, replay_warmup;
+extern int telemetry_interval;
+extern char *checkpoint_file;
+extern char *trace_file;
+extern bool quiet;
+
+/*************************** imported from simulate.cpp ***************************/
+extern thread_local std::list<Request*> requests;
+extern thread_local std::list<Request*>::iterator next_arrival;
+extern thread_local unsigned int arrived_count;
+extern thread_local unsigned int completed_count;
+extern thread_local WriteBackCache *write_cache;
+extern thread_local Telemetry *telemetry;
+
+
+/*************************** global variables ***************************/
+static const char CHECKPOINT_MAGIC[8] = {'I', 'O', 'S', 'C', 'H', 'K', '0', '8'};
+static const int LOG_LINE = -1; // id marking a printed line in the log instead of a completed request
+std::vector<Request*> unlogged; // requests completed since the last checkpoint
+std::vector<std::string> unlogged_lines; // lines printed since the last checkpoint
+long long log_length = -1; // bytes of the log covered by the last checkpoint, -1 before the first
+std::list<Request*>::iterator oldest_pending; // no request before it is pending
+bool oldest_pending_set; // whether oldest_pending points into requests
+
+
+/*************************** function declarations ***************************/
+void get_config(char algo, std::list<int> &config);
+bool append_log(std::string filename);
+bool replay_log(std::string filename, long long length, std::vector<Request*> &by_id);
+void write_request(FILE *file, Request *request);
+void read_request(FILE *file, Request *request);
+
+
+void log_completion(Request *request) {
+	/*
+		Function Name: log_completion
+		Arguments: Request *request: request which is completed
+		Returns: void
+		Description: remembers the request so that its result goes to the log with the next checkpoint
+	*/
+	unlogged.push_back(request);
+}
+
+
+void log_output(const char *line) {
+	/*
+		Function Name: log_output
+		Arguments: const char *line: line printed during the run
+		Returns: void
+		Description: remembers the line so that it goes to the log with the next checkpoint and is printed
+			again on resume. Nothing is kept when no checkpoints are taken.
+	*/
+	if(checkpoint_file != NULL) {
+		unlogged_lines.push_back(line);
+	}
+}
+
+
+bool save_checkpoint(char *filename, char algo, Scheduler *sched, Device *device) {
+	/*
+		Function Name: save_checkpoint
+		Arguments: char *filename: checkpoint file, char algo, Scheduler *sched, Device *device
+		Returns: bool: false if checkpoint could not be written
+		Description: writes the state of the simulation at start of current tick. Results completed since
+			the last checkpoint are appended to the log first. The checkpoint is written to a temporary file
+			and then renamed, so an interruption never leaves a partial checkpoint.
+	*/
+	if(!append_log(std::string(filename) + ".log")) {
+		return false;
+	}
+
+	std::string temp_filename = std::string(filename) + ".tmp";
+	FILE *file = fopen(temp_filename.c_str(), "wb");
+	if(file == NULL) {
+		return false;
+	}
+
+	// configuration, checked on resume so that the checkpoint is not applied to another run
+	fwrite(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), 1, file);
+	std::list<int> config;
+	get_config(algo, config);
+	CheckpointIO::write_ints(file, config);
+
+	// clock, head and counters, the device saves its own state after the scheduler
+	CheckpointIO::write_int(file, curr_time);
+	CheckpointIO::write_int(file, curr_head_location);
+	CheckpointIO::write_int(file, arrived_count);
+	CheckpointIO::write_int(file, completed_count);
+	CheckpointIO::write_long(file, log_length);
+
+	// completed requests are in the log and those not arrived yet are as read from the input,
+	// so only the pending ones are saved. They all lie between oldest_pending and next_arrival.
+	if(!oldest_pending_set) {
+		oldest_pending = requests.begin();
+		oldest_pending_set = true;
+	}
+	while(oldest_pending != next_arrival && (*oldest_pending)->state == COMPLETE) {
+		oldest_pending++;
+	}
+	std::list<Request*>::iterator it;
+	CheckpointIO::write_int(file, arrived_count - completed_count);
+	for(it = oldest_pending; it != next_arrival; it++) {
+		if((*it)->state != COMPLETE) {
+			CheckpointIO::write_int(file, (*it)->state);
+			write_request(file, *it);
+		}
+	}
+
+	sched->save(file);
+	device->save(file);
+	if(write_cache != NULL) {
+		write_cache->save(file);
+	}
+	if(telemetry != NULL) {
+		telemetry->save(file);
+	}
+
+	bool ok = !ferror(file);
+	if(fclose(file) != 0 || !ok) {
+		return false;
+	}
+	return rename(temp_filename.c_str(), filename) == 0;
+}
+
+
+bool load_checkpoint(char *filename, char algo, Scheduler *sched, Device *device) {
+	/*
+		Function Name: load_checkpoint
+		Arguments: char *filename: checkpoint file, char algo, Scheduler *sched, Device *device
+		Returns: bool: false if checkpoint is missing, corrupt or belongs to another configuration
+		Description: restores the state of the simulation written by save_checkpoint
+	*/
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	FILE *file = fopen(filename, "rb");
+	if(file == NULL) {
+		return false;
+	}
+
+	std::list<int> config, saved_config;
+	get_config(algo, config);
+	if(fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+		fclose(file);
+		return false;
+	}
+	CheckpointIO::read_ints(file, saved_config);
+	if(saved_config != config) {
+		fclose(file);
+		return false;
+	}
+
+	// requests indexed by id, ids are assigned in order of the list
+	std::vector<Request*> by_id(requests.begin(), requests.end());
+
+	curr_time = CheckpointIO::read_int(file);
+	curr_head_location = CheckpointIO::read_int(file);
+	arrived_count = CheckpointIO::read_int(file);
+	completed_count = CheckpointIO::read_int(file);
+	long long length = CheckpointIO::read_long(file);
+	if(arrived_count > requests.size() || completed_count > arrived_count) {
+		fclose(file);
+		return false;
+	}
+	next_arrival = requests.begin();
+	for(unsigned int i = 0; i < arrived_count; i++) {
+		next_arrival++;
+	}
+
+	// results of completed requests come from the log, the pending ones from the checkpoint
+	if(length >= 0 && !replay_log(std::string(filename) + ".log", length, by_id)) {
+		fclose(file);
+		return false;
+	}
+	int pending = CheckpointIO::read_int(file);
+	for(int i = 0; i < pending; i++) {
+		State state = (State)CheckpointIO::read_int(file);
+		int id = CheckpointIO::read_int(file);
+		if(id < 0 || id >= (int)by_id.size()) {
+			fclose(file);
+			return false;
+		}
+		read_request(file, by_id[id]);
+		by_id[id]->state = state;
+	}
+	log_length = length;
+
+	bool ok = sched->load(file, by_id) && device->load(file, by_id);
+	if(ok && write_cache != NULL) {
+		ok = write_cache->load(file, by_id);
+	}
+	if(ok && telemetry != NULL) {
+		ok = telemetry->load(file);
+	}
+	ok = ok && !ferror(file) && !feof(file);
+	fclose(file);
+	return ok;
+}
+
+
+void get_config(char algo, std::list<int> &config) {
+	/*
+		Function Name: get_config
+		Arguments: char algo, std::list<int> &config: filled with the configuration
+		Returns: void
+		Description: lists every option which affects the course of the simulation, so that a checkpoint
+			is only resumed with exactly the input and options it was taken with. The input is identified
+			by the size and modification time of the trace, as the trace index does.
+	*/
+	long long trace_size = -1, trace_mtime = -1;
+	struct stat trace_stat;
+	if(trace_file != NULL && stat(trace_file, &trace_stat) == 0) {
+		trace_size = trace_stat.st_size;
+		trace_mtime = trace_stat.st_mtime;
+	}
+
+	config.clear();
+	config.push_back(algo);
+	config.push_back(requests.size());
+	config.push_back(trace_size >> 32);
+	config.push_back(trace_size & 0xffffffff);
+	config.push_back(trace_mtime >> 32);
+	config.push_back(trace_mtime & 0xffffffff);
+	config.push_back(replay_from);
+	config.push_back(replay_to);
+	config.push_back(replay_warmup);
+	config.push_back(cache_capacity);
+	config.push_back(cache_high_watermark);
+	config.push_back(cache_low_watermark);
+	config.push_back(ssd);
+	config.push_back(ssd ? ssd_channels : 0);
+	config.push_back(ssd ? ssd_read_time : 0);
+	config.push_back(ssd ? ssd_write_time : 0);
+	config.push_back(ssd && ssd_channel_aware);
+	config.push_back(geometry != NULL);
+	if(geometry != NULL) {
+		config.push_back(geometry->cylinders);
+		config.push_back(geometry->heads);
+		config.push_back(geometry->zones);
+		config.push_back(geometry->outer_sectors);
+		config.push_back(geometry->inner_sectors);
+		config.push_back(geometry->revolution_ticks);
+		config.push_back(geometry->tick_us);
+	}
+	config.push_back(anticipation_window);
+	config.push_back(anticipation_window > 0 ? anticipation_distance : 0);
+	config.push_back(telemetry != NULL);
+	config.push_back(telemetry != NULL ? telemetry_interval : 0);
+}
+
+
+bool append_log(std::string filename) {
+	/*
+		Function Name: append_log
+		Arguments: std::string filename: log of completed requests
+		Returns: bool: false if the log could not be written
+		Description: appends the results of the requests completed and the lines printed since the last
+			checkpoint. The log is started afresh by the first checkpoint of a run which is not resumed.
+	*/
+	FILE *file = fopen(filename.c_str(), log_length < 0 ? "wb" : "ab");
+	if(file == NULL) {
+		return false;
+	}
+	for(unsigned int i = 0; i < unlogged.size(); i++) {
+		write_request(file, unlogged[i]);
+	}
+	for(unsigned int i = 0; i < unlogged_lines.size(); i++) {
+		CheckpointIO::write_int(file, LOG_LINE);
+		CheckpointIO::write_string(file, unlogged_lines[i]);
+	}
+	fflush(file);
+	long long length = ftell(file);
+	bool ok = !ferror(file);
+	if(fclose(file) != 0 || !ok) {
+		return false;
+	}
+	unlogged.clear();
+	unlogged_lines.clear();
+	log_length = length;
+	return true;
+}
+
+
+bool replay_log(std::string filename, long long length, std::vector<Request*> &by_id) {
+	/*
+		Function Name: replay_log
+		Arguments: std::string filename: log of completed requests, long long length: bytes of it covered
+			by the checkpoint, std::vector<Request*> &by_id: requests indexed by id
+		Returns: bool: false if the log is shorter than at checkpoint or inconsistent
+		Description: restores the results of the requests completed before the checkpoint, prints again the
+			lines printed before it as they are part of the output of an uninterrupted run, and drops whatever
+			was appended to the log after it
+	*/
+	FILE *file = fopen(filename.c_str(), "r+b");
+	if(file == NULL) {
+		return false;
+	}
+	bool ok = true;
+	std::string line;
+	while(ok && ftell(file) < length) {
+		int id = CheckpointIO::read_int(file);
+		if(id == LOG_LINE) {
+			ok = CheckpointIO::read_string(file, line);
+			if(ok && !quiet) {
+				printf("%s", line.c_str());
+			}
+		} else if(id >= 0 && id < (int)by_id.size()) {
+			read_request(file, by_id[id]);
+			by_id[id]->state = COMPLETE;
+		} else {
+			ok = false;
+		}
+	}
+	ok = ok && ftell(file) == length && !ferror(file) && ftruncate(fileno(file), length) == 0;
+	fclose(file);
+	return ok;
+}
+
+
+void write_request(FILE *file, Request *request) {
+	/*
+		Function Name: write_request
+		Arguments: FILE *file, Request *request
+		Returns: void
+		Description: writes the id of the request and its results so far
+	*/
+	CheckpointIO::write_int(file, request->request_id);
+	CheckpointIO::write_int(file, request->start_time);
+	CheckpointIO::write_int(file, request->end_time);
+	CheckpointIO::write_int(file, request->wait_time);
+	CheckpointIO::write_int(file, request->turn_around_time);
+	CheckpointIO::write_int(file, request->ack_time);
+	CheckpointIO::write_int(file, request->cached);
+	CheckpointIO::write_int(file, request->seek_distance);
+}
+
+
+void read_request(FILE *file, Request *request) {
+	/*
+		Function Name: read_request
+		Arguments: FILE *file, Request *request: filled with the results read
+		Returns: void
+		Description: reads the results written by write_request after the id
+	*/
+	request->start_time = CheckpointIO::read_int(file);
+	request->end_time = CheckpointIO::read_int(file);
+	request->wait_time = CheckpointIO::read_int(file);
+	request->turn_around_time = CheckpointIO::read_int(file);
+	request->ack_time = CheckpointIO::read_int(file);
+	request->cached = CheckpointIO::read_int(file);
+	request->seek_distance = CheckpointIO::read_int(file);
+}
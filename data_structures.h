@@ -3,10 +3,28 @@
 	Description: Defines all the data structures and schedulers used in the program
 */
 #include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
 #include <list>
+#include <vector>
+#include <string>
+#include <coroutine>
+#include <exception>
+
+/*************************** imported from simulate.cpp ***************************/
+extern thread_local int curr_head_location;
+extern thread_local int curr_time;
+extern thread_local bool shadow_run;
 
 /*************************** imported from main.cpp ***************************/
-extern int curr_head_location;
+extern bool quiet;
+
+/*************************** imported from checkpoint.cpp ***************************/
+extern void log_output(const char *line);
+
+/*************************** imported from readinput.cpp ***************************/
+extern int first_request_id;
 
 #ifndef STATE_H
 #define STATE_H
@@ -31,29 +49,470 @@ public:
 	int track_required;
 	int wait_time;
 	int turn_around_time;
+	bool is_write; // whether request is a write, otherwise it is a read
+	int ack_time; // time at which the write was acknowledged, -1 if not yet
+	long long lba; // first logical block of request, its track if no geometry is given
+	int size; // number of sectors transferred
+	int transfer_time; // ticks taken to transfer the sectors once head is on the cylinder
+	bool cached; // whether write was absorbed by the write-back cache and flushed later
+	int seek_distance; // head movement spent reaching the track of request
 	State state;
 
 
 	/*************************** Constructor ***************************/
-	Request(int request_id, int arrival_time, int track_required, State state) {
+	Request(int request_id, int arrival_time, int track_required, State state, bool is_write = false) {
 		this->request_id = request_id;
 		this->arrival_time = arrival_time;
 		this->track_required = track_required;
 		this->state = state;
+		this->is_write = is_write;
+		this->ack_time = -1;
+		this->lba = track_required;
+		this->size = 0;
+		this->transfer_time = 0;
+		this->cached = false;
+		this->seek_distance = 0;
 	}
+};
+
+
+#endif
+
+#ifndef CHECKPOINT_IO_H
+#define CHECKPOINT_IO_H
 
+class CheckpointIO {
+	/*
+		Class Name: CheckpointIO
+		Description: helpers to write and read the binary checkpoint file. Read errors are not checked
+			on every value, the caller checks the file with ferror and feof once done.
+	*/
+public:
+	static void write_int(FILE *file, int value) {
+		/*
+			Function Name: write_int
+			Arguments: FILE *file, int value
+			Returns: void
+			Description: writes an int in binary
+		*/
+		fwrite(&value, sizeof(value), 1, file);
+	}
 
-	void print_request() {
+	static int read_int(FILE *file) {
 		/*
-			Function Name: print_request
-			Arguments: void
+			Function Name: read_int
+			Arguments: FILE *file
+			Returns: int: value read, -1 at end of file
+			Description: reads an int written by write_int
+		*/
+		int value = 0;
+		if(fread(&value, sizeof(value), 1, file) != 1) {
+			return -1;
+		}
+		return value;
+	}
+
+	static void write_long(FILE *file, long long value) {
+		/*
+			Function Name: write_long
+			Arguments: FILE *file, long long value
+			Returns: void
+			Description: writes a long in binary
+		*/
+		fwrite(&value, sizeof(value), 1, file);
+	}
+
+	static long long read_long(FILE *file) {
+		/*
+			Function Name: read_long
+			Arguments: FILE *file
+			Returns: long long: value read, -1 at end of file
+			Description: reads a long written by write_long
+		*/
+		long long value = 0;
+		if(fread(&value, sizeof(value), 1, file) != 1) {
+			return -1;
+		}
+		return value;
+	}
+
+	static void write_double(FILE *file, double value) {
+		/*
+			Function Name: write_double
+			Arguments: FILE *file, double value
+			Returns: void
+			Description: writes a double in binary
+		*/
+		fwrite(&value, sizeof(value), 1, file);
+	}
+
+	static double read_double(FILE *file) {
+		/*
+			Function Name: read_double
+			Arguments: FILE *file
+			Returns: double: value read, -1 at end of file
+			Description: reads a double written by write_double
+		*/
+		double value = 0;
+		if(fread(&value, sizeof(value), 1, file) != 1) {
+			return -1;
+		}
+		return value;
+	}
+
+	static void write_string(FILE *file, std::string &value) {
+		/*
+			Function Name: write_string
+			Arguments: FILE *file, std::string &value
+			Returns: void
+			Description: writes the length of the string followed by its characters
+		*/
+		write_int(file, value.size());
+		fwrite(value.data(), 1, value.size(), file);
+	}
+
+	static bool read_string(FILE *file, std::string &value) {
+		/*
+			Function Name: read_string
+			Arguments: FILE *file, std::string &value: filled with the string read
+			Returns: bool: false if the string is cut short
+			Description: reads a string written by write_string
+		*/
+		int length = read_int(file);
+		if(length < 0) {
+			return false;
+		}
+		value.resize(length);
+		return length == 0 || fread(&value[0], 1, length, file) == (size_t)length;
+	}
+
+	static void write_ints(FILE *file, std::list<int> &values) {
+		/*
+			Function Name: write_ints
+			Arguments: FILE *file, std::list<int> &values
+			Returns: void
+			Description: writes the count of values followed by the values
+		*/
+		write_int(file, values.size());
+		std::list<int>::iterator it;
+		for(it = values.begin(); it != values.end(); it++) {
+			write_int(file, *it);
+		}
+	}
+
+	static void read_ints(FILE *file, std::list<int> &values) {
+		/*
+			Function Name: read_ints
+			Arguments: FILE *file, std::list<int> &values: filled with the values read
+			Returns: void
+			Description: reads values written by write_ints
+		*/
+		values.clear();
+		int count = read_int(file);
+		for(int i = 0; i < count && !feof(file); i++) {
+			values.push_back(read_int(file));
+		}
+	}
+
+	static void write_queue(FILE *file, std::list<Request*> &queue) {
+		/*
+			Function Name: write_queue
+			Arguments: FILE *file, std::list<Request*> &queue
 			Returns: void
-			Description: prints the information of request in the required format
+			Description: writes the queue as count followed by ids of requests in queue order
+		*/
+		write_int(file, queue.size());
+		std::list<Request*>::iterator it;
+		for(it = queue.begin(); it != queue.end(); it++) {
+			write_int(file, (*it)->request_id);
+		}
+	}
+
+	static bool read_queue(FILE *file, std::list<Request*> &queue, std::vector<Request*> &by_id) {
+		/*
+			Function Name: read_queue
+			Arguments: FILE *file, std::list<Request*> &queue: filled with the requests, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if the queue refers to a request which does not exist
+			Description: reads a queue written by write_queue
+		*/
+		queue.clear();
+		int count = read_int(file);
+		for(int i = 0; i < count; i++) {
+			int id = read_int(file);
+			if(id < 0 || id >= (int)by_id.size()) {
+				return false;
+			}
+			queue.push_back(by_id[id]);
+		}
+		return true;
+	}
+};
+
+#endif
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+class Summary {
+	/*
+		Class Name: Summary
+		Description: holds the results of one simulation run
+	*/
+public:
+	int total_time;
+	int tot_movement;
+	int requests; // requests counted in the averages, i.e. all but the warmup requests of a replay
+	double avg_turnaround_time;
+	double avg_wait_time;
+	int max_wait_time;
+	bool has_writes; // whether any request was a write
+	double avg_read_latency;
+	double avg_write_ack_latency;
+	int flushes; // batches flushed by write-back cache
+	int writeback_movement; // head movement measured on the disk to reach the flushed writes
+	int saved_movement; // head movement saved against a run without the write-back cache
+	int channels; // channels of ssd, 0 for disk
+	double channel_utilization; // fraction of channel ticks spent serving requests
+	int blocked_ticks; // ticks in which dispatch was blocked on a busy channel
+	long long bytes; // bytes transferred by all requests
+	double avg_transfer_time; // average ticks spent transferring per request
+	int anticipations; // times the head was held after a completion waiting for a nearby request
+	int anticipation_hits; // anticipations in which a nearby request arrived within the window
+	int anticipation_saved; // head movement saved against a run without anticipation
+};
+
+#endif
+
+#ifndef WORKLOAD_PARAMS_H
+#define WORKLOAD_PARAMS_H
+
+class WorkloadParams {
+	/*
+		Class Name: WorkloadParams
+		Description: parameters of the distribution from which random workloads are generated
+	*/
+public:
+	int num_requests; // requests per workload
+	double mean_gap; // mean time between arrivals outside bursts
+	int max_track; // tracks are drawn from [0, max_track)
+	double hot_fraction; // fraction of requests going to the first tenth of the tracks
+	double seq_fraction; // fraction of requests continuing sequentially from the previous one
+	double burst_prob; // probability that an arrival starts a burst of back to back arrivals
+	double mean_burst_len; // mean number of requests in a burst
+	double write_fraction; // fraction of requests which are writes
+	unsigned int seed; // base seed, workload k uses the stream seeded with (seed, k)
+
+	/*************************** Constructor ***************************/
+	WorkloadParams() {
+		num_requests = 1000;
+		mean_gap = 100;
+		max_track = 500;
+		hot_fraction = 0;
+		seq_fraction = 0;
+		burst_prob = 0;
+		mean_burst_len = 10;
+		write_fraction = 0;
+		seed = 1;
+	}
+};
+
+#endif
+
+#ifndef DISK_GEOMETRY_H
+#define DISK_GEOMETRY_H
+
+#define SECTOR_SIZE 512 // bytes per sector
+
+class DiskGeometry {
+	/*
+		Class Name: DiskGeometry
+		Description: cylinder/head/sector layout of a disk with zoned bit recording. Cylinders are split into
+			equal zones, the outermost zone (cylinder 0) has the most sectors per track and every zone inwards
+			has linearly fewer. The disk spins at a constant rate, so outer zones transfer faster.
+	*/
+public:
+	int cylinders;
+	int heads; // tracks per cylinder
+	int zones;
+	int outer_sectors; // sectors per track in the outermost zone
+	int inner_sectors; // sectors per track in the innermost zone
+	int revolution_ticks; // ticks taken by one revolution
+	int tick_us; // microseconds per tick, used to report throughput
+
+	/*************************** Constructor ***************************/
+	DiskGeometry() {
+		cylinders = 1000;
+		heads = 4;
+		zones = 10;
+		outer_sectors = 1000;
+		inner_sectors = 500;
+		revolution_ticks = 83;
+		tick_us = 100;
+	}
+
+	bool is_valid() {
+		/*
+			Function Name: is_valid
+			Arguments: void
+			Returns: bool
+			Description: checks that every zone has at least one cylinder and every track at least one sector
+		*/
+		return cylinders > 0 && heads > 0 && zones > 0 && zones <= cylinders && inner_sectors > 0
+			&& outer_sectors >= inner_sectors && revolution_ticks > 0 && tick_us > 0;
+	}
+
+	int zone_cylinders(int zone) {
+		/*
+			Function Name: zone_cylinders
+			Arguments: int zone
+			Returns: int: number of cylinders in the zone, the last zone takes the remainder
+		*/
+		int count = cylinders / zones;
+		return zone == zones - 1 ? cylinders - count * (zones - 1) : count;
+	}
+
+	int sectors_per_track(int zone) {
+		/*
+			Function Name: sectors_per_track
+			Arguments: int zone
+			Returns: int
+			Description: gives the sectors on one track of the zone, interpolated from outer to inner zone
+		*/
+		if(zones == 1) {
+			return outer_sectors;
+		}
+		return outer_sectors - (long long)(outer_sectors - inner_sectors) * zone / (zones - 1);
+	}
+
+	long long capacity() {
+		/*
+			Function Name: capacity
+			Arguments: void
+			Returns: long long: number of sectors on the disk
+		*/
+		long long sectors = 0;
+		for(int zone = 0; zone < zones; zone++) {
+			sectors += (long long)zone_cylinders(zone) * heads * sectors_per_track(zone);
+		}
+		return sectors;
+	}
+
+	bool map(long long lba, int *cylinder, int *head, int *sector, int *zone) {
+		/*
+			Function Name: map
+			Arguments: long long lba, int *cylinder, int *head, int *sector, int *zone: location of lba
+			Returns: bool: false if lba is beyond the disk
+			Description: maps logical block to its cylinder, head and sector, filling cylinders from outside in
 		*/
-		printf("%5d: %5d %5d %5d\n", request_id, arrival_time, start_time, end_time);
+		int first_cylinder = 0;
+		if(lba < 0) {
+			return false;
+		}
+		for(int z = 0; z < zones; z++) {
+			long long track_sectors = sectors_per_track(z);
+			long long zone_sectors = zone_cylinders(z) * heads * track_sectors;
+			if(lba < zone_sectors) {
+				*zone = z;
+				*cylinder = first_cylinder + lba / (heads * track_sectors);
+				*head = (lba / track_sectors) % heads;
+				*sector = lba % track_sectors;
+				return true;
+			}
+			lba -= zone_sectors;
+			first_cylinder += zone_cylinders(z);
+		}
+		return false;
+	}
+
+	int transfer_time(int zone, int size) {
+		/*
+			Function Name: transfer_time
+			Arguments: int zone: zone of the first sector, int size: sectors to transfer
+			Returns: int: ticks taken, rounded up
+			Description: a track passes under the head once per revolution, so size sectors take
+				size / sectors_per_track revolutions
+		*/
+		long long track_sectors = sectors_per_track(zone);
+		return ((long long)size * revolution_ticks + track_sectors - 1) / track_sectors;
 	}
 };
 
+#endif
+
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#define TRACE_INDEX_INTERVAL 10000 // arrival ticks between two entries of trace index
+
+class TraceIndex {
+	/*
+		Class Name: TraceIndex
+		Description: offsets into a trace file at fixed arrival time intervals. Entry k points to the first
+			request arriving at or after k * interval, with the id that request gets when the whole trace is read.
+	*/
+public:
+	int interval;
+	int request_count; // requests in the whole trace
+	long long trace_size; // size of the trace the index was built from
+	long long trace_mtime; // modification time of that trace
+	std::vector<long long> offsets;
+	std::vector<int> ids;
+
+	/*************************** Constructor ***************************/
+	TraceIndex() {
+		interval = TRACE_INDEX_INTERVAL;
+		request_count = 0;
+		trace_size = 0;
+		trace_mtime = 0;
+	}
+
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: index file
+			Returns: void
+			Description: writes the index after its header
+		*/
+		fwrite("IOSIDX02", 1, 8, file);
+		CheckpointIO::write_int(file, interval);
+		CheckpointIO::write_int(file, request_count);
+		CheckpointIO::write_long(file, trace_size);
+		CheckpointIO::write_long(file, trace_mtime);
+		CheckpointIO::write_int(file, offsets.size());
+		for(int i = 0; i < (int)offsets.size(); i++) {
+			CheckpointIO::write_long(file, offsets[i]);
+			CheckpointIO::write_int(file, ids[i]);
+		}
+	}
+
+	bool load(FILE *file) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: index file
+			Returns: bool: false if file is not an index
+			Description: restores the index written by save
+		*/
+		char magic[8];
+		if(fread(magic, 1, 8, file) != 8 || memcmp(magic, "IOSIDX02", 8) != 0) {
+			return false;
+		}
+		interval = CheckpointIO::read_int(file);
+		request_count = CheckpointIO::read_int(file);
+		trace_size = CheckpointIO::read_long(file);
+		trace_mtime = CheckpointIO::read_long(file);
+		int count = CheckpointIO::read_int(file);
+		if(interval <= 0 || request_count < 0 || count < 0) {
+			return false;
+		}
+		offsets.resize(count);
+		ids.resize(count);
+		for(int i = 0; i < count; i++) {
+			offsets[i] = CheckpointIO::read_long(file);
+			ids[i] = CheckpointIO::read_int(file);
+		}
+		return !ferror(file) && !feof(file);
+	}
+};
 
 #endif
 
@@ -68,6 +527,9 @@ class Scheduler {
 	*/
 public:
 
+	/*************************** Destructor ***************************/
+	virtual ~Scheduler() {}
+
 	/*************************** Virtual Function Definitions ***************************/
 	virtual Request *get_next_request() {
 		/*
@@ -96,6 +558,42 @@ public:
 		*/
 		return;
 	}
+	virtual void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the queue and any other state of the scheduler to checkpoint
+		*/
+		return;
+	}
+	virtual bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the state written by save
+		*/
+		return true;
+	}
+	virtual int next_event() {
+		/*
+			Function Name: next_event
+			Arguments: void
+			Returns: int: tick at which the scheduler changes its mind on its own, INT_MAX if never
+			Description: lets a scheduler which holds requests back wake up the simulation
+		*/
+		return INT_MAX;
+	}
+	virtual void summarize(Summary *summary) {
+		/*
+			Function Name: summarize
+			Arguments: Summary *summary
+			Returns: void
+			Description: fills in the statistics specific to the scheduler
+		*/
+		return;
+	}
 
 };
 
@@ -143,10 +641,30 @@ public:
 		*/
 		std::list<Request*>::iterator it;
 		for (it = queue.begin(); it != queue.end(); ++it){
-    		printf("%d: %d %d\n", (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
+    		printf("%d: %d %d\n", first_request_id + (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
 		}
 	}
 
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the queue to checkpoint
+		*/
+		CheckpointIO::write_queue(file, queue);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the queue from checkpoint
+		*/
+		return CheckpointIO::read_queue(file, queue, by_id);
+	}
+
 };
 
 #endif
@@ -207,10 +725,30 @@ public:
 		*/
 		std::list<Request*>::iterator it;
 		for (it = queue.begin(); it != queue.end(); ++it){
-    		printf("%d: %d %d\n", (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
+    		printf("%d: %d %d\n", first_request_id + (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
 		}
 	}
 
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the queue to checkpoint
+		*/
+		CheckpointIO::write_queue(file, queue);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the queue from checkpoint
+		*/
+		return CheckpointIO::read_queue(file, queue, by_id);
+	}
+
 	int get_seek_time(Request *request) {
 		/*
 			Function Name: get_seek_time
@@ -237,8 +775,8 @@ class LookScheduler : public Scheduler {
 	std::list<Request*> queue;
 	bool forward_direction; // holds the direction in which to move the header
 public:
-	LookScheduler() {
-		forward_direction = true;
+	LookScheduler(bool forward_direction = true) {
+		this->forward_direction = forward_direction;
 	}
 
 	void add_request(Request *request) {
@@ -323,10 +861,32 @@ public:
 		*/
 		std::list<Request*>::iterator it;
 		for (it = queue.begin(); it != queue.end(); ++it){
-    		printf("%d: %d %d\n", (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
+    		printf("%d: %d %d\n", first_request_id + (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
 		}
 	}
 
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the direction and queue to checkpoint
+		*/
+		CheckpointIO::write_int(file, forward_direction);
+		CheckpointIO::write_queue(file, queue);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the direction and queue from checkpoint
+		*/
+		forward_direction = CheckpointIO::read_int(file) == 1;
+		return CheckpointIO::read_queue(file, queue, by_id);
+	}
+
 	int get_seek_time(Request *request) {
 		/*
 			Function Name: get_seek_time
@@ -421,10 +981,30 @@ public:
 		*/
 		std::list<Request*>::iterator it;
 		for (it = queue.begin(); it != queue.end(); ++it){
-    		printf("%d: %d %d\n", (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
+    		printf("%d: %d %d\n", first_request_id + (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
 		}
 	}
 
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the queue to checkpoint
+		*/
+		CheckpointIO::write_queue(file, queue);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the queue from checkpoint
+		*/
+		return CheckpointIO::read_queue(file, queue, by_id);
+	}
+
 	int get_seek_time(Request *request) {
 		/*
 			Function Name: get_seek_time
@@ -541,10 +1121,33 @@ public:
 		*/
 		std::list<Request*>::iterator it;
 		for (it = queue1.begin(); it != queue1.end(); ++it){
-    		printf("%d: %d %d\n", (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
+    		printf("%d: %d %d\n", first_request_id + (*it)->request_id, (*it)->arrival_time, (*it)->track_required);
 		}
 	}
 
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the direction and both queues to checkpoint
+		*/
+		CheckpointIO::write_int(file, forward_direction);
+		CheckpointIO::write_queue(file, queue1);
+		CheckpointIO::write_queue(file, queue2);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the direction and both queues from checkpoint
+		*/
+		forward_direction = CheckpointIO::read_int(file) == 1;
+		return CheckpointIO::read_queue(file, queue1, by_id) && CheckpointIO::read_queue(file, queue2, by_id);
+	}
+
 	int get_seek_time(Request *request) {
 		/*
 			Function Name: get_seek_time
@@ -560,4 +1163,1582 @@ public:
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
+#ifndef ADAPTIVE_SCHEDULER_H
+#define ADAPTIVE_SCHEDULER_H
+
+#define ADAPTIVE_WINDOW 32 // number of recent arrivals and dispatches sampled by adaptive scheduler
+#define NARROW_SPREAD 0.25 // recent arrivals spanning at most this fraction of the highest track are a narrow region
+#define DEEP_QUEUE 4 // queue depth from which requests spread wide are swept by LOOK
+#define STARVATION_FACTOR 3 // oldest queued request waiting beyond this multiple of average wait is starving
+#define SWITCH_INTERVAL 4 // multiple of window of arrivals and dispatches to be seen between two switches
+
+/*************************** imported from simulate.cpp ***************************/
+extern Scheduler* create_scheduler(char algo);
+
+class AdaptiveScheduler : public Scheduler {
+	/*
+		Class Name: AdaptiveScheduler
+		Description: meta scheduler which samples queue depth, track spread and wait times over a sliding
+			window and switches the active algorithm between SSTF and LOOK at runtime
+	*/
+	std::list<Request*> pending; // all requests in queue in arrival order, used to hand over on switch
+	std::list<int> recent_tracks; // tracks of recently arrived requests
+	std::list<int> recent_waits; // wait times of recently dispatched requests
+	int highest_track; // highest track among all arrivals, against which the spread is judged
+	bool moving_up; // direction of the last seek, kept by LOOK when it takes over
+	int window; // number of samples kept
+	int samples_since_switch; // arrivals and dispatches seen since the last switch
+	Scheduler *active;
+public:
+	char active_algo;
+	int switches;
+
+	/*************************** Constructor ***************************/
+	AdaptiveScheduler(int window) {
+		this->window = window;
+		highest_track = 0;
+		moving_up = true;
+		samples_since_switch = SWITCH_INTERVAL * window;
+		switches = 0;
+		active_algo = 's';
+		active = create_scheduler(active_algo);
+	}
+
+	~AdaptiveScheduler() {
+		delete active;
+	}
+
+	void add_request(Request *request) {
+		/*
+			Function Name: add_request
+			Arguments: Request *request: request to be inserted in queue
+			Returns: void
+			Description: inserts the new request in the queue and samples its track
+		*/
+		pending.push_back(request);
+		active->add_request(request);
+		samples_since_switch++;
+
+		recent_tracks.push_back(request->track_required);
+		if((int)recent_tracks.size() > window) {
+			recent_tracks.pop_front();
+		}
+		if(request->track_required > highest_track) {
+			highest_track = request->track_required;
+		}
+	}
+
+	Request* get_next_request() {
+		/*
+			Function Name: get_next_request
+			Arguments: void
+			Returns: Request*: request to be processed next
+			Description: reconsiders the active algorithm and then gives the next request as per it
+		*/
+		if(pending.size() == 0) {
+			return NULL;
+		}
+		choose_algorithm();
+
+		Request *request = active->get_next_request();
+		moving_up = request->track_required >= curr_head_location;
+		pending.remove(request);
+		samples_since_switch++;
+
+		recent_waits.push_back(curr_time - request->arrival_time);
+		if((int)recent_waits.size() > window) {
+			recent_waits.pop_front();
+		}
+		return request;
+	}
+
+	void print_queue() {
+		/*
+			Function Name: print_queue
+			Arguments: void
+			Returns: void
+			Description: prints all the requests of the queue
+		*/
+		active->print_queue();
+	}
+
+	void choose_algorithm() {
+		/*
+			Function Name: choose_algorithm
+			Arguments: void
+			Returns: void
+			Description: picks the algorithm suited to the sampled workload and switches to it if it differs.
+				Arrivals in a narrow region go to SSTF, which serves them without sweeping past the region.
+				Arrivals spread wide go to LOOK once the queue is deep, as SSTF then leaves the far requests
+				waiting, and to SSTF while it is shallow unless the oldest queued request is starving.
+		*/
+		int depth = pending.size();
+
+		// with one request there is no choice to be made, and switching too often only thrashes
+		if(depth <= 1 || samples_since_switch < SWITCH_INTERVAL * window || recent_tracks.size() == 0) {
+			return;
+		}
+
+		int spread = get_track_spread();
+		int oldest_wait = curr_time - pending.front()->arrival_time;
+		double avg_wait = 0;
+		std::list<int>::iterator it;
+		for(it = recent_waits.begin(); it != recent_waits.end(); it++) {
+			avg_wait += (*it);
+		}
+		if(recent_waits.size() > 0) {
+			avg_wait = avg_wait / recent_waits.size();
+		}
+
+		char algo;
+		if(spread <= NARROW_SPREAD * highest_track) {
+			algo = 'j';
+		} else if(depth >= DEEP_QUEUE || oldest_wait > STARVATION_FACTOR * avg_wait) {
+			algo = 's';
+		} else {
+			algo = 'j';
+		}
+		if(algo == active_algo) {
+			return;
+		}
+
+		if(!quiet && !shadow_run) {
+			char line[128];
+			snprintf(line, sizeof(line), "SWITCH: %d %c %c %d %d %.2lf %d\n", curr_time, active_algo, algo, depth, spread, avg_wait, oldest_wait);
+			printf("%s", line);
+			log_output(line);
+		}
+
+		// hand the pending requests over to the new scheduler in their arrival order,
+		// LOOK carries on in the direction the head is already moving
+		delete active;
+		active = algo == 's' ? new LookScheduler(moving_up) : create_scheduler(algo);
+		std::list<Request*>::iterator req;
+		for(req = pending.begin(); req != pending.end(); req++) {
+			active->add_request(*req);
+		}
+		active_algo = algo;
+		samples_since_switch = 0;
+		switches++;
+	}
+
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the samples, pending requests and state of active scheduler to checkpoint
+		*/
+		CheckpointIO::write_queue(file, pending);
+		CheckpointIO::write_ints(file, recent_tracks);
+		CheckpointIO::write_ints(file, recent_waits);
+		CheckpointIO::write_int(file, highest_track);
+		CheckpointIO::write_int(file, moving_up);
+		CheckpointIO::write_int(file, samples_since_switch);
+		CheckpointIO::write_int(file, switches);
+		CheckpointIO::write_int(file, active_algo);
+		active->save(file);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the state written by save
+		*/
+		if(!CheckpointIO::read_queue(file, pending, by_id)) {
+			return false;
+		}
+		CheckpointIO::read_ints(file, recent_tracks);
+		CheckpointIO::read_ints(file, recent_waits);
+		highest_track = CheckpointIO::read_int(file);
+		moving_up = CheckpointIO::read_int(file);
+		samples_since_switch = CheckpointIO::read_int(file);
+		switches = CheckpointIO::read_int(file);
+		active_algo = CheckpointIO::read_int(file);
+
+		delete active;
+		active = create_scheduler(active_algo);
+		return active != NULL && active->load(file, by_id);
+	}
+
+	int get_track_spread() {
+		/*
+			Function Name: get_track_spread
+			Arguments: void
+			Returns: int
+			Description: gives the distance between lowest and highest track among recent arrivals
+		*/
+		int low = recent_tracks.front(), high = recent_tracks.front();
+		std::list<int>::iterator it;
+		for(it = recent_tracks.begin(); it != recent_tracks.end(); it++) {
+			if((*it) < low) low = (*it);
+			if((*it) > high) high = (*it);
+		}
+		return high - low;
+	}
+};
+
+#endif
+
+#ifndef ANTICIPATORY_SCHEDULER_H
+#define ANTICIPATORY_SCHEDULER_H
+
+#define ANTICIPATION_STREAMS 16 // streams whose think time is learned, least recently completed is replaced
+#define THINK_SMOOTHING 0.25 // weight of latest sample in moving average of think time of a stream
+
+class AnticipatoryScheduler : public Scheduler {
+	/*
+		Class Name: AnticipatoryScheduler
+		Description: wraps any scheduler and, after a request completes, keeps the head idle for a short
+			window waiting for the next request of the same stream instead of seeking away at once.
+			A stream is a run of requests within distance of each other, and its think time (from a
+			completion to the next arrival) is learned so that streams which come back too late are
+			not waited for.
+	*/
+	class Stream {
+		/*
+			Class Name: Stream
+			Description: learned behaviour of one stream
+		*/
+	public:
+		int last_track; // track of the last completed request of stream
+		int last_end; // completion time of that request
+		bool waiting; // whether the next request of stream has not yet arrived
+		double think_time; // moving average of time from completion to next arrival
+		int samples; // number of think times seen
+	};
+
+	Scheduler *inner;
+	std::list<Request*> pending; // requests queued in inner scheduler
+	std::vector<Stream> streams;
+	int window; // ticks to wait after a completion
+	int distance; // tracks from head within which a request counts as nearby
+	Request *last; // last dispatched request, completed once the next request is asked for
+	Request *anticipated; // nearby request which arrived while waiting, dispatched next
+	bool anticipating;
+	int anticipate_until; // tick at which waiting gives up
+public:
+	int anticipations;
+	int hits;
+
+	/*************************** Constructor ***************************/
+	AnticipatoryScheduler(Scheduler *inner, int window, int distance) {
+		this->inner = inner;
+		this->window = window;
+		this->distance = distance;
+		last = NULL;
+		anticipated = NULL;
+		anticipating = false;
+		anticipate_until = 0;
+		anticipations = 0;
+		hits = 0;
+	}
+
+	~AnticipatoryScheduler() {
+		delete inner;
+	}
+
+	void add_request(Request *request) {
+		/*
+			Function Name: add_request
+			Arguments: Request *request: request to be inserted in queue
+			Returns: void
+			Description: samples the think time of the stream of the request. A nearby request arriving
+				while waiting is kept aside to be dispatched next, the rest go to the inner scheduler.
+		*/
+		int stream = find_stream(request->track_required, true);
+		if(stream >= 0 && request->arrival_time >= streams[stream].last_end) {
+			double think = request->arrival_time - streams[stream].last_end;
+			if(streams[stream].samples == 0) {
+				streams[stream].think_time = think;
+			} else {
+				streams[stream].think_time += THINK_SMOOTHING * (think - streams[stream].think_time);
+			}
+			streams[stream].samples++;
+			streams[stream].waiting = false;
+		}
+
+		int gap = track_distance(request->track_required);
+		if(anticipating && gap <= distance) {
+			hits++;
+			anticipating = false;
+			anticipated = request;
+			return;
+		}
+		pending.push_back(request);
+		inner->add_request(request);
+	}
+
+	Request* get_next_request() {
+		/*
+			Function Name: get_next_request
+			Arguments: void
+			Returns: Request*: request to be processed next, NULL while waiting for a nearby request
+			Description: on the first call after a completion decides whether to wait for its stream,
+				then gives the anticipated request, nothing until the window is over, or the request
+				chosen by the inner scheduler
+		*/
+		if(anticipated != NULL) {
+			last = anticipated;
+			anticipated = NULL;
+			return last;
+		}
+
+		if(last != NULL) {
+			complete(last);
+			last = NULL;
+		}
+		if(anticipating) {
+			if(curr_time < anticipate_until) {
+				return NULL;
+			}
+			anticipating = false;
+		}
+
+		Request *request = inner->get_next_request();
+		if(request != NULL) {
+			pending.remove(request);
+		}
+		last = request;
+		return request;
+	}
+
+	void complete(Request *request) {
+		/*
+			Function Name: complete
+			Arguments: Request *request: request which just completed
+			Returns: void
+			Description: records the completion in the stream of the request and starts waiting for its next
+				request unless the stream thinks too long or a nearby request is already queued
+		*/
+		int stream = find_stream(request->track_required, false);
+		if(stream < 0) {
+			// replace the stream which completed least recently
+			stream = 0;
+			if((int)streams.size() < ANTICIPATION_STREAMS) {
+				streams.push_back(Stream());
+				stream = streams.size() - 1;
+			} else {
+				for(int i = 1; i < (int)streams.size(); i++) {
+					if(streams[i].last_end < streams[stream].last_end) {
+						stream = i;
+					}
+				}
+			}
+			streams[stream].samples = 0;
+			streams[stream].think_time = 0;
+		}
+		streams[stream].last_track = request->track_required;
+		streams[stream].last_end = curr_time;
+		streams[stream].waiting = true;
+
+		if(streams[stream].samples > 0 && streams[stream].think_time > window) {
+			return;
+		}
+		if(pending.size() > 0 && nearest_pending() <= distance) {
+			return;
+		}
+		anticipating = true;
+		anticipate_until = curr_time + window;
+		anticipations++;
+	}
+
+	int find_stream(int track, bool waiting) {
+		/*
+			Function Name: find_stream
+			Arguments: int track, bool waiting: whether only streams waiting for their next request are searched
+			Returns: int: index of the stream whose last track is closest to track within distance, -1 if none
+		*/
+		int found = -1, best = distance + 1;
+		for(int i = 0; i < (int)streams.size(); i++) {
+			int gap = track - streams[i].last_track;
+			if(gap < 0) {
+				gap = -gap;
+			}
+			if(gap < best && (!waiting || streams[i].waiting)) {
+				best = gap;
+				found = i;
+			}
+		}
+		return found;
+	}
+
+	int nearest_pending() {
+		/*
+			Function Name: nearest_pending
+			Arguments: void
+			Returns: int: seek distance from head to the closest queued request, 0 if queue is empty
+		*/
+		int nearest = INT_MAX;
+		std::list<Request*>::iterator it;
+		for(it = pending.begin(); it != pending.end(); it++) {
+			int gap = track_distance((*it)->track_required);
+			if(gap < nearest) {
+				nearest = gap;
+			}
+		}
+		return nearest == INT_MAX ? 0 : nearest;
+	}
+
+	int track_distance(int track) {
+		/*
+			Function Name: track_distance
+			Arguments: int track
+			Returns: int: seek distance from head to track
+		*/
+		return track > curr_head_location ? track - curr_head_location : curr_head_location - track;
+	}
+
+	void print_queue() {
+		/*
+			Function Name: print_queue
+			Arguments: void
+			Returns: void
+			Description: prints all the requests of the queue
+		*/
+		inner->print_queue();
+	}
+
+	int next_event() {
+		/*
+			Function Name: next_event
+			Arguments: void
+			Returns: int: tick at which waiting gives up, INT_MAX if not waiting
+		*/
+		return anticipating ? anticipate_until : INT_MAX;
+	}
+
+	void summarize(Summary *summary) {
+		/*
+			Function Name: summarize
+			Arguments: Summary *summary
+			Returns: void
+			Description: fills in the anticipation statistics
+		*/
+		summary->anticipations = anticipations;
+		summary->anticipation_hits = hits;
+	}
+
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the waiting state, learned streams and state of inner scheduler to checkpoint
+		*/
+		CheckpointIO::write_queue(file, pending);
+		CheckpointIO::write_int(file, last != NULL ? last->request_id : -1);
+		CheckpointIO::write_int(file, anticipated != NULL ? anticipated->request_id : -1);
+		CheckpointIO::write_int(file, anticipating);
+		CheckpointIO::write_int(file, anticipate_until);
+		CheckpointIO::write_int(file, anticipations);
+		CheckpointIO::write_int(file, hits);
+		CheckpointIO::write_int(file, streams.size());
+		for(int i = 0; i < (int)streams.size(); i++) {
+			CheckpointIO::write_int(file, streams[i].last_track);
+			CheckpointIO::write_int(file, streams[i].last_end);
+			CheckpointIO::write_int(file, streams[i].waiting);
+			CheckpointIO::write_double(file, streams[i].think_time);
+			CheckpointIO::write_int(file, streams[i].samples);
+		}
+		inner->save(file);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the state written by save
+		*/
+		if(!CheckpointIO::read_queue(file, pending, by_id)) {
+			return false;
+		}
+		int last_id = CheckpointIO::read_int(file);
+		int anticipated_id = CheckpointIO::read_int(file);
+		if(last_id >= (int)by_id.size() || anticipated_id >= (int)by_id.size()) {
+			return false;
+		}
+		last = last_id >= 0 ? by_id[last_id] : NULL;
+		anticipated = anticipated_id >= 0 ? by_id[anticipated_id] : NULL;
+		anticipating = CheckpointIO::read_int(file);
+		anticipate_until = CheckpointIO::read_int(file);
+		anticipations = CheckpointIO::read_int(file);
+		hits = CheckpointIO::read_int(file);
+		int count = CheckpointIO::read_int(file);
+		if(count < 0 || count > ANTICIPATION_STREAMS) {
+			return false;
+		}
+		streams.resize(count);
+		for(int i = 0; i < count; i++) {
+			streams[i].last_track = CheckpointIO::read_int(file);
+			streams[i].last_end = CheckpointIO::read_int(file);
+			streams[i].waiting = CheckpointIO::read_int(file);
+			streams[i].think_time = CheckpointIO::read_double(file);
+			streams[i].samples = CheckpointIO::read_int(file);
+		}
+		return inner->load(file, by_id);
+	}
+};
+
+#endif
+
+#ifndef WRITE_BACK_CACHE_H
+#define WRITE_BACK_CACHE_H
+
+class WriteBackCache {
+	/*
+		Class Name: WriteBackCache
+		Description: models the write-back cache of the disk. Writes are acknowledged as soon as they
+			are absorbed in the cache and are later flushed to the scheduler in sorted batches.
+	*/
+	std::list<Request*> dirty; // absorbed writes not yet flushed, in arrival order
+public:
+	int capacity; // maximum number of dirty writes the cache can hold
+	int high_watermark; // flush is started when dirty writes reach this count
+	int low_watermark; // flush stops when dirty writes come down to this count
+	int flushes; // number of batches flushed
+	int writeback_movement; // head movement measured on the device to reach the flushed writes
+
+	/*************************** Constructor ***************************/
+	WriteBackCache(int capacity, int high_watermark, int low_watermark) {
+		this->capacity = capacity;
+		this->high_watermark = high_watermark;
+		this->low_watermark = low_watermark;
+		flushes = 0;
+		writeback_movement = 0;
+	}
+
+	bool is_full() {
+		/*
+			Function Name: is_full
+			Arguments: void
+			Returns: bool
+			Description: checks whether cache has no space left for another write
+		*/
+		return (int)dirty.size() >= capacity;
+	}
+
+	bool needs_flush() {
+		/*
+			Function Name: needs_flush
+			Arguments: void
+			Returns: bool
+			Description: checks whether dirty writes have reached the high watermark
+		*/
+		return (int)dirty.size() >= high_watermark;
+	}
+
+	int dirty_count() {
+		/*
+			Function Name: dirty_count
+			Arguments: void
+			Returns: int
+			Description: gives the number of dirty writes in the cache
+		*/
+		return dirty.size();
+	}
+
+	void absorb(Request *request) {
+		/*
+			Function Name: absorb
+			Arguments: Request *request: write request to be absorbed
+			Returns: void
+			Description: stores the write in the cache
+		*/
+		dirty.push_back(request);
+	}
+
+	std::list<Request*> flush(int target) {
+		/*
+			Function Name: flush
+			Arguments: int target: number of dirty writes to be left in the cache
+			Returns: std::list<Request*>: batch of writes in the order they should be issued
+			Description: takes the oldest dirty writes out of the cache until only target are left
+				and sorts them in elevator order, i.e. upwards from the head and then wrapping around
+		*/
+		std::list<Request*> batch, behind;
+		while((int)dirty.size() > target) {
+			batch.push_back(dirty.front());
+			dirty.pop_front();
+		}
+		if(batch.size() == 0) {
+			return batch;
+		}
+
+		// sort by track and then move the tracks behind the head to the end of the batch
+		batch.sort(compare_track);
+		while(batch.size() > 0 && batch.front()->track_required < curr_head_location) {
+			behind.push_back(batch.front());
+			batch.pop_front();
+		}
+		batch.splice(batch.end(), behind);
+		flushes++;
+		return batch;
+	}
+
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the dirty writes and flush statistics to checkpoint
+		*/
+		CheckpointIO::write_queue(file, dirty);
+		CheckpointIO::write_int(file, flushes);
+		CheckpointIO::write_int(file, writeback_movement);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the dirty writes and flush statistics from checkpoint
+		*/
+		if(!CheckpointIO::read_queue(file, dirty, by_id)) {
+			return false;
+		}
+		flushes = CheckpointIO::read_int(file);
+		writeback_movement = CheckpointIO::read_int(file);
+		return true;
+	}
+
+	static bool compare_track(Request *a, Request *b) {
+		/*
+			Function Name: compare_track
+			Arguments: Request *a, Request *b
+			Returns: bool
+			Description: orders requests by the track required
+		*/
+		return a->track_required < b->track_required;
+	}
+};
+
+#endif
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#define TELEMETRY_BUFFER_SIZE (1 << 20) // size of output buffer of telemetry file
+#define WAIT_SMOOTHING 0.125 // weight of latest window in moving average of wait time
+
+class Telemetry {
+	/*
+		Class Name: Telemetry
+		Description: records downsampled time series of the simulation to a csv file. Every tick is only
+			accumulated into the current window and one row is written per window, so it is cheap enough
+			to be kept on for long runs.
+	*/
+	FILE *file;
+	int interval; // ticks per window
+	int window_end; // time at which the current window ends
+	long long queue_sum; // sum of queue depth over ticks of window
+	int ticks; // ticks seen in window
+	int head_min, head_max; // extent of head sweep in window
+	int completions; // requests completed in window
+	long long wait_sum; // sum of wait time of requests completed in window
+	double avg_wait; // moving average of wait time over windows
+public:
+
+	/*************************** Constructor ***************************/
+	Telemetry(FILE *file, int interval, bool write_header = true) {
+		this->file = file;
+		this->interval = interval;
+		window_end = interval;
+		avg_wait = -1;
+		setvbuf(file, NULL, _IOFBF, TELEMETRY_BUFFER_SIZE);
+		if(write_header) {
+			fprintf(file, "time,queue,avg_queue,head,head_min,head_max,completions,avg_wait\n");
+		}
+		reset_window();
+	}
+
+	~Telemetry() {
+		fclose(file);
+	}
+
+	void start(int time) {
+		/*
+			Function Name: start
+			Arguments: int time: tick at which the simulation starts
+			Returns: void
+			Description: aligns the first window to the start of the simulation, which is not 0 in replay mode
+		*/
+		window_end = time + interval;
+		reset_window();
+	}
+
+	void reset_window() {
+		/*
+			Function Name: reset_window
+			Arguments: void
+			Returns: void
+			Description: clears the accumulators of the window
+		*/
+		queue_sum = 0;
+		ticks = 0;
+		head_min = curr_head_location;
+		head_max = curr_head_location;
+		completions = 0;
+		wait_sum = 0;
+	}
+
+	void tick(int queue_depth) {
+		/*
+			Function Name: tick
+			Arguments: int queue_depth: requests waiting in the IO queue
+			Returns: void
+			Description: accumulates the state at end of the current tick and writes a row when window is over
+		*/
+		queue_sum += queue_depth;
+		ticks++;
+		if(curr_head_location < head_min) head_min = curr_head_location;
+		if(curr_head_location > head_max) head_max = curr_head_location;
+		if(curr_time + 1 >= window_end) {
+			write_row(curr_time, queue_depth);
+		}
+	}
+
+	void completed(Request *request) {
+		/*
+			Function Name: completed
+			Arguments: Request *request: request which is completed
+			Returns: void
+			Description: counts the completion and its wait time towards the window
+		*/
+		completions++;
+		wait_sum += request->wait_time;
+	}
+
+	void save(FILE *checkpoint) {
+		/*
+			Function Name: save
+			Arguments: FILE *checkpoint: checkpoint file
+			Returns: void
+			Description: writes the current window and the length of the telemetry file to checkpoint
+		*/
+		fflush(file);
+		CheckpointIO::write_long(checkpoint, ftell(file));
+		CheckpointIO::write_int(checkpoint, window_end);
+		CheckpointIO::write_long(checkpoint, queue_sum);
+		CheckpointIO::write_int(checkpoint, ticks);
+		CheckpointIO::write_int(checkpoint, head_min);
+		CheckpointIO::write_int(checkpoint, head_max);
+		CheckpointIO::write_int(checkpoint, completions);
+		CheckpointIO::write_long(checkpoint, wait_sum);
+		CheckpointIO::write_double(checkpoint, avg_wait);
+	}
+
+	bool load(FILE *checkpoint) {
+		/*
+			Function Name: load
+			Arguments: FILE *checkpoint: checkpoint file
+			Returns: bool: false if telemetry file is shorter than at checkpoint
+			Description: restores the current window and drops the rows written after the checkpoint
+		*/
+		long long length = CheckpointIO::read_long(checkpoint);
+		window_end = CheckpointIO::read_int(checkpoint);
+		queue_sum = CheckpointIO::read_long(checkpoint);
+		ticks = CheckpointIO::read_int(checkpoint);
+		head_min = CheckpointIO::read_int(checkpoint);
+		head_max = CheckpointIO::read_int(checkpoint);
+		completions = CheckpointIO::read_int(checkpoint);
+		wait_sum = CheckpointIO::read_long(checkpoint);
+		avg_wait = CheckpointIO::read_double(checkpoint);
+
+		fseek(file, 0, SEEK_END);
+		if(length < 0 || ftell(file) < length) {
+			return false;
+		}
+		fflush(file);
+		if(ftruncate(fileno(file), length) != 0) {
+			return false;
+		}
+		fseek(file, length, SEEK_SET);
+		return true;
+	}
+
+	void write_row(int time, int queue_depth) {
+		/*
+			Function Name: write_row
+			Arguments: int time: last tick of the window, int queue_depth: requests waiting in the IO queue at end of window
+			Returns: void
+			Description: writes the row of the current window and starts the next one
+		*/
+		if(ticks == 0) {
+			return;
+		}
+		if(completions > 0) {
+			double window_wait = (double)wait_sum / completions;
+			avg_wait = avg_wait < 0 ? window_wait : avg_wait + WAIT_SMOOTHING * (window_wait - avg_wait);
+		}
+		fprintf(file, "%d,%d,%.2lf,%d,%d,%d,%d,%.2lf\n", time, queue_depth, (double)queue_sum / ticks,
+			curr_head_location, head_min, head_max, completions, avg_wait < 0 ? 0 : avg_wait);
+		window_end += interval;
+		reset_window();
+	}
+};
+
+#endif
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+/*************************** imported from simulate.cpp ***************************/
+extern bool verbose, print_queue;
+extern Request* fetch_request(Scheduler *sched);
+extern void issue_request(Request *request, int position);
+extern void finish_request(Request *request, int curr_time);
+
+class Device {
+	/*
+		Class Name: Device
+		Description: defines a parent virtual Device class which serves the requests given by the scheduler
+	*/
+public:
+	int tot_movement; // head movement done by the device
+
+	/*************************** Constructor ***************************/
+	Device() {
+		tot_movement = 0;
+	}
+
+	/*************************** Destructor ***************************/
+	virtual ~Device() {}
+
+	/*************************** Virtual Function Definitions ***************************/
+	virtual void service(Scheduler *sched) {
+		/*
+			Function Name: service
+			Arguments: Scheduler *sched: IO queue to take requests from
+			Returns: void
+			Description: advances the requests in service by one tick, completes the finished ones and
+				takes new requests from the scheduler when the device has room for them
+		*/
+		return;
+	}
+	virtual int in_service() {
+		/*
+			Function Name: in_service
+			Arguments: void
+			Returns: int
+			Description: gives the number of requests being served by the device
+		*/
+		return 0;
+	}
+	virtual int next_event() {
+		/*
+			Function Name: next_event
+			Arguments: void
+			Returns: int: tick at which the device completes its next request, INT_MAX if it is idle
+			Description: gives the next tick at which the device does more than just progress its requests
+		*/
+		return INT_MAX;
+	}
+	virtual void advance(int ticks) {
+		/*
+			Function Name: advance
+			Arguments: int ticks: number of ticks to skip, all before next_event
+			Returns: void
+			Description: progresses the requests in service as if ticks in which nothing else happens were simulated
+		*/
+		return;
+	}
+	virtual void summarize(Summary *summary) {
+		/*
+			Function Name: summarize
+			Arguments: Summary *summary: filled with statistics of the device
+			Returns: void
+			Description: fills the device statistics of the summary
+		*/
+		summary->tot_movement = tot_movement;
+		summary->channels = 0;
+		summary->channel_utilization = 0;
+		summary->blocked_ticks = 0;
+	}
+	virtual void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the state of the device to checkpoint
+		*/
+		CheckpointIO::write_int(file, tot_movement);
+	}
+	virtual bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the state written by save
+		*/
+		tot_movement = CheckpointIO::read_int(file);
+		return true;
+	}
+};
+
+#endif
+
+#ifndef DISK_DEVICE_H
+#define DISK_DEVICE_H
+
+class DiskDevice : public Device {
+	/*
+		Class Name: DiskDevice
+		Description: rotating disk with a single head which moves one track per tick. Once on the track
+			the request takes its transfer time before it completes.
+	*/
+	Request *curr_request; // request being served
+	int transfer_left; // ticks of transfer left for current request once head is on its track
+public:
+
+	/*************************** Constructor ***************************/
+	DiskDevice() {
+		curr_request = NULL;
+		transfer_left = 0;
+	}
+
+	void service(Scheduler *sched) {
+		/*
+			Function Name: service
+			Arguments: Scheduler *sched: IO queue to take requests from
+			Returns: void
+			Description: moves the head towards the current request or transfers its data if already on
+				its track, completes it once transfer is over and then issues the next request
+		*/
+
+		// if any request is running currently then do its processing
+		if(curr_request != NULL) {
+
+			// if header is away from the track required then move it accordingly
+			if(curr_head_location < curr_request->track_required) {
+				curr_head_location++;
+				tot_movement++;
+				curr_request->seek_distance++;
+			} else if(curr_head_location > curr_request->track_required) {
+				curr_head_location--;
+				tot_movement++;
+				curr_request->seek_distance++;
+			} else if(transfer_left > 0) {
+				transfer_left--;
+			}
+
+			// if header is on the track required and data is transferred then fininsh the request
+			// also do the corresponding accounting calculations
+			if(curr_head_location == curr_request->track_required && transfer_left == 0) {
+				finish_request(curr_request, curr_time);
+				curr_request = NULL;
+			}
+		}
+
+
+		// if there is no request going on currently then get new one from IO queue
+		if(curr_request == NULL) {
+			curr_request = fetch_request(sched);
+
+			// if there is request pending in queue then process it.
+			if(curr_request != NULL) {
+				if(print_queue && !shadow_run) {
+					printf("\n\n");
+					sched->print_queue();
+					printf("\n\n");
+				}
+				issue_request(curr_request, curr_head_location);
+				transfer_left = curr_request->transfer_time;
+
+				// if we get requests for the same track header is on 
+				// then keep on completing it
+				while(curr_head_location == curr_request->track_required && transfer_left == 0) {
+					// accounting to be performed when request is completed
+					finish_request(curr_request, curr_time);
+
+					// again get new request and repeat the process
+					curr_request = sched->get_next_request();
+					if(curr_request == NULL) {
+						break;
+					} else {
+						issue_request(curr_request, curr_head_location);
+						transfer_left = curr_request->transfer_time;
+					}
+				}
+			}
+		}
+	}
+
+	int in_service() {
+		/*
+			Function Name: in_service
+			Arguments: void
+			Returns: int
+			Description: gives the number of requests being served by the device
+		*/
+		return curr_request != NULL ? 1 : 0;
+	}
+
+	int next_event() {
+		/*
+			Function Name: next_event
+			Arguments: void
+			Returns: int: tick at which head reaches the track of current request and transfers its data,
+				INT_MAX if idle
+			Description: gives the tick at which the current request completes
+		*/
+		if(curr_request == NULL) {
+			return INT_MAX;
+		}
+		int distance = curr_head_location - curr_request->track_required;
+		if(distance < 0) {
+			distance = -distance;
+		}
+		return curr_time + distance + transfer_left - 1;
+	}
+
+	void advance(int ticks) {
+		/*
+			Function Name: advance
+			Arguments: int ticks: number of ticks to skip, all before next_event
+			Returns: void
+			Description: moves the head towards the track of current request, and spends the ticks left
+				after reaching it on transfer
+		*/
+		if(curr_request == NULL) {
+			return;
+		}
+		int distance = curr_head_location - curr_request->track_required;
+		if(distance < 0) {
+			distance = -distance;
+		}
+		int moves = ticks < distance ? ticks : distance;
+		if(curr_head_location < curr_request->track_required) {
+			curr_head_location += moves;
+		} else {
+			curr_head_location -= moves;
+		}
+		tot_movement += moves;
+		curr_request->seek_distance += moves;
+		transfer_left -= ticks - moves;
+	}
+
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the head movement, current request and its transfer left to checkpoint
+		*/
+		Device::save(file);
+		CheckpointIO::write_int(file, curr_request != NULL ? curr_request->request_id : -1);
+		CheckpointIO::write_int(file, transfer_left);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the head movement, current request and its transfer left from checkpoint
+		*/
+		Device::load(file, by_id);
+		int id = CheckpointIO::read_int(file);
+		transfer_left = CheckpointIO::read_int(file);
+		if(id >= (int)by_id.size()) {
+			return false;
+		}
+		curr_request = id >= 0 ? by_id[id] : NULL;
+		return true;
+	}
+};
+
+#endif
+
+#ifndef SSD_DEVICE_H
+#define SSD_DEVICE_H
+
+class SSDDevice : public Device {
+	/*
+		Class Name: SSDDevice
+		Description: flash device with independent channels which serve requests concurrently. There is no
+			seek, a read or write takes a fixed number of ticks on the channel its address is mapped to.
+			Addresses are striped over channels, so consecutive tracks go to consecutive channels.
+			Requests are dispatched in the order of the scheduler. In order dispatch stops at the first
+			request whose channel is busy, channel aware dispatch looks past it for requests of idle channels.
+	*/
+	int channels;
+	int read_time, write_time; // ticks taken by a read and a write
+	bool channel_aware;
+	std::vector<Request*> serving; // request being served on each channel, NULL if idle
+	std::vector<int> remaining; // ticks left for the request on each channel
+	std::list<Request*> dispatch_queue; // requests taken from scheduler but not yet started, in scheduler order
+	long long busy_ticks; // sum over ticks of channels serving a request
+	long long ticks;
+	int blocked_ticks;
+public:
+
+	/*************************** Constructor ***************************/
+	SSDDevice(int channels, int read_time, int write_time, bool channel_aware) {
+		this->channels = channels;
+		this->read_time = read_time;
+		this->write_time = write_time;
+		this->channel_aware = channel_aware;
+		serving.assign(channels, NULL);
+		remaining.assign(channels, 0);
+		busy_ticks = 0;
+		ticks = 0;
+		blocked_ticks = 0;
+	}
+
+	int get_channel(Request *request) {
+		/*
+			Function Name: get_channel
+			Arguments: Request *request
+			Returns: int
+			Description: maps the address of the request to its channel
+		*/
+		return request->track_required % channels;
+	}
+
+	void service(Scheduler *sched) {
+		/*
+			Function Name: service
+			Arguments: Scheduler *sched: IO queue to take requests from
+			Returns: void
+			Description: advances every channel by one tick, completes the finished requests and
+				dispatches requests to the idle channels
+		*/
+		for(int c = 0; c < channels; c++) {
+			if(serving[c] != NULL && --remaining[c] == 0) {
+				finish_request(serving[c], curr_time);
+				serving[c] = NULL;
+			}
+		}
+
+		Request *request;
+		if(channel_aware) {
+			// take the whole queue and start every request whose channel is idle, in scheduler order
+			while((request = fetch_request(sched)) != NULL) {
+				dispatch_queue.push_back(request);
+			}
+			std::list<Request*>::iterator it = dispatch_queue.begin();
+			while(it != dispatch_queue.end()) {
+				int channel = get_channel(*it);
+				if(serving[channel] == NULL) {
+					start_request(*it, channel);
+					it = dispatch_queue.erase(it);
+				} else {
+					it++;
+				}
+			}
+		} else {
+			// the next request waits for its channel and blocks the ones behind it
+			while(true) {
+				if(dispatch_queue.size() == 0) {
+					request = fetch_request(sched);
+					if(request == NULL) {
+						break;
+					}
+					dispatch_queue.push_back(request);
+				}
+				int channel = get_channel(dispatch_queue.front());
+				if(serving[channel] != NULL) {
+					blocked_ticks++;
+					break;
+				}
+				start_request(dispatch_queue.front(), channel);
+				dispatch_queue.pop_front();
+			}
+		}
+
+		busy_ticks += in_service();
+		ticks++;
+	}
+
+	void start_request(Request *request, int channel) {
+		/*
+			Function Name: start_request
+			Arguments: Request *request, int channel: channel to serve it on
+			Returns: void
+			Description: issues the request on the channel
+		*/
+		issue_request(request, channel);
+		// schedulers order by distance from the last dispatched address
+		curr_head_location = request->track_required;
+		serving[channel] = request;
+		remaining[channel] = request->is_write ? write_time : read_time;
+	}
+
+	int in_service() {
+		/*
+			Function Name: in_service
+			Arguments: void
+			Returns: int
+			Description: gives the number of requests being served by the channels
+		*/
+		int busy = 0;
+		for(int c = 0; c < channels; c++) {
+			if(serving[c] != NULL) {
+				busy++;
+			}
+		}
+		return busy;
+	}
+
+	int next_event() {
+		/*
+			Function Name: next_event
+			Arguments: void
+			Returns: int: tick at which the first channel completes its request, INT_MAX if all are idle
+			Description: gives the tick of the next completion
+		*/
+		int next = INT_MAX;
+		for(int c = 0; c < channels; c++) {
+			if(serving[c] != NULL && curr_time + remaining[c] - 1 < next) {
+				next = curr_time + remaining[c] - 1;
+			}
+		}
+		return next;
+	}
+
+	void advance(int count) {
+		/*
+			Function Name: advance
+			Arguments: int count: number of ticks to skip, all before next_event
+			Returns: void
+			Description: progresses every busy channel by count ticks
+		*/
+		for(int c = 0; c < channels; c++) {
+			if(serving[c] != NULL) {
+				remaining[c] -= count;
+			}
+		}
+		busy_ticks += (long long)in_service() * count;
+		ticks += count;
+		// in order dispatch stays blocked on the request waiting for its channel
+		if(!channel_aware && dispatch_queue.size() > 0) {
+			blocked_ticks += count;
+		}
+	}
+
+	void summarize(Summary *summary) {
+		/*
+			Function Name: summarize
+			Arguments: Summary *summary: filled with statistics of the device
+			Returns: void
+			Description: fills the channel utilization and blocking statistics of the summary
+		*/
+		Device::summarize(summary);
+		summary->channels = channels;
+		summary->channel_utilization = ticks > 0 ? (double)busy_ticks / (ticks * channels) : 0;
+		summary->blocked_ticks = blocked_ticks;
+	}
+
+	void save(FILE *file) {
+		/*
+			Function Name: save
+			Arguments: FILE *file: checkpoint file
+			Returns: void
+			Description: writes the channels, dispatch queue and statistics to checkpoint
+		*/
+		Device::save(file);
+		for(int c = 0; c < channels; c++) {
+			CheckpointIO::write_int(file, serving[c] != NULL ? serving[c]->request_id : -1);
+			CheckpointIO::write_int(file, remaining[c]);
+		}
+		CheckpointIO::write_queue(file, dispatch_queue);
+		CheckpointIO::write_long(file, busy_ticks);
+		CheckpointIO::write_long(file, ticks);
+		CheckpointIO::write_int(file, blocked_ticks);
+	}
+
+	bool load(FILE *file, std::vector<Request*> &by_id) {
+		/*
+			Function Name: load
+			Arguments: FILE *file: checkpoint file, std::vector<Request*> &by_id: requests indexed by id
+			Returns: bool: false if checkpoint is inconsistent
+			Description: restores the channels, dispatch queue and statistics from checkpoint
+		*/
+		Device::load(file, by_id);
+		for(int c = 0; c < channels; c++) {
+			int id = CheckpointIO::read_int(file);
+			if(id >= (int)by_id.size()) {
+				return false;
+			}
+			serving[c] = id >= 0 ? by_id[id] : NULL;
+			remaining[c] = CheckpointIO::read_int(file);
+		}
+		if(!CheckpointIO::read_queue(file, dispatch_queue, by_id)) {
+			return false;
+		}
+		busy_ticks = CheckpointIO::read_long(file);
+		ticks = CheckpointIO::read_long(file);
+		blocked_ticks = CheckpointIO::read_int(file);
+		return true;
+	}
+};
+
+#endif
+
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#define RESULT_BUFFER_SIZE (1 << 20) // size of buffer in which results are formatted
+#define RESULT_RECORD_MAX 128 // maximum bytes taken by the result of one request in any format
+
+class ResultWriter {
+	/*
+		Class Name: ResultWriter
+		Description: writes the result of every request to a file in bulk. Results are formatted into a large
+			buffer with hand written integer formatting and the buffer is written out whenever it is full.
+			Format is 't' for the text lines "id: arrival start end", 'c' for csv or 'b' for binary records
+			of native 32 bit integers: id, arrival, start, end, wait, turnaround, is write, ack.
+	*/
+	FILE *file;
+	char format;
+	char *buffer;
+	int used; // bytes of buffer filled
+public:
+
+	/*************************** Constructor ***************************/
+	ResultWriter(FILE *file, char format) {
+		this->file = file;
+		this->format = format;
+		buffer = new char[RESULT_BUFFER_SIZE];
+		used = 0;
+		if(format == 'c') {
+			append_string("id,arrival,start,end,wait,turnaround,write,ack\n");
+		} else if(format == 'b') {
+			append_string("IORES001");
+		}
+	}
+
+	~ResultWriter() {
+		flush();
+		delete[] buffer;
+	}
+
+	void write(Request *request) {
+		/*
+			Function Name: write
+			Arguments: Request *request: completed request
+			Returns: void
+			Description: appends the result of the request in the format of the writer
+		*/
+		if(used > RESULT_BUFFER_SIZE - RESULT_RECORD_MAX) {
+			flush();
+		}
+		if(format == 't') {
+			// same as "%5d: %5d %5d %5d\n"
+			append_int(first_request_id + request->request_id, 5);
+			buffer[used++] = ':';
+			buffer[used++] = ' ';
+			append_int(request->arrival_time, 5);
+			buffer[used++] = ' ';
+			append_int(request->start_time, 5);
+			buffer[used++] = ' ';
+			append_int(request->end_time, 5);
+			buffer[used++] = '\n';
+		} else if(format == 'c') {
+			append_int(first_request_id + request->request_id, 0);
+			buffer[used++] = ',';
+			append_int(request->arrival_time, 0);
+			buffer[used++] = ',';
+			append_int(request->start_time, 0);
+			buffer[used++] = ',';
+			append_int(request->end_time, 0);
+			buffer[used++] = ',';
+			append_int(request->wait_time, 0);
+			buffer[used++] = ',';
+			append_int(request->turn_around_time, 0);
+			buffer[used++] = ',';
+			append_int(request->is_write ? 1 : 0, 0);
+			buffer[used++] = ',';
+			append_int(request->ack_time, 0);
+			buffer[used++] = '\n';
+		} else {
+			int record[8] = {first_request_id + request->request_id, request->arrival_time, request->start_time, request->end_time,
+				request->wait_time, request->turn_around_time, request->is_write ? 1 : 0, request->ack_time};
+			memcpy(buffer + used, record, sizeof(record));
+			used += sizeof(record);
+		}
+	}
+
+	void append_int(int value, int width) {
+		/*
+			Function Name: append_int
+			Arguments: int value, int width: minimum width, padded with spaces on the left
+			Returns: void
+			Description: appends the decimal form of value to the buffer
+		*/
+		char digits[12];
+		int count = 0;
+		long long magnitude = value < 0 ? -(long long)value : value;
+		do {
+			digits[count++] = '0' + magnitude % 10;
+			magnitude /= 10;
+		} while(magnitude > 0);
+		if(value < 0) {
+			digits[count++] = '-';
+		}
+		for(int pad = width - count; pad > 0; pad--) {
+			buffer[used++] = ' ';
+		}
+		while(count > 0) {
+			buffer[used++] = digits[--count];
+		}
+	}
+
+	void append_string(const char *text) {
+		/*
+			Function Name: append_string
+			Arguments: const char *text
+			Returns: void
+			Description: appends the text to the buffer
+		*/
+		int length = strlen(text);
+		memcpy(buffer + used, text, length);
+		used += length;
+	}
+
+	void flush() {
+		/*
+			Function Name: flush
+			Arguments: void
+			Returns: void
+			Description: writes out the buffer
+		*/
+		if(used > 0) {
+			fwrite(buffer, 1, used, file);
+			used = 0;
+		}
+	}
+};
+
+#endif
+
+#ifndef DEVICE_TASK_H
+#define DEVICE_TASK_H
+
+class DeviceTask {
+	/*
+		Class Name: DeviceTask
+		Description: coroutine simulating one device. It suspends with the time of its next event and
+			is resumed by the event loop when that time is the earliest among the devices.
+	*/
+public:
+	class promise_type {
+		/*
+			Class Name: promise_type
+			Description: promise of the coroutine, holds the time it yielded
+		*/
+	public:
+		int next_time;
+
+		DeviceTask get_return_object() {
+			return DeviceTask(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept {
+			return std::suspend_always();
+		}
+		std::suspend_always final_suspend() noexcept {
+			return std::suspend_always();
+		}
+		std::suspend_always yield_value(int time) {
+			next_time = time;
+			return std::suspend_always();
+		}
+		void return_void() {}
+		void unhandled_exception() {
+			std::terminate();
+		}
+	};
+
+	std::coroutine_handle<promise_type> handle;
+
+	/*************************** Constructor ***************************/
+	DeviceTask(std::coroutine_handle<promise_type> handle) {
+		this->handle = handle;
+	}
+
+	DeviceTask(DeviceTask &&other) {
+		handle = other.handle;
+		other.handle = NULL;
+	}
+
+	~DeviceTask() {
+		destroy();
+	}
+
+	bool resume() {
+		/*
+			Function Name: resume
+			Arguments: void
+			Returns: bool: false once the simulation of the device is over
+			Description: runs the device until its next event
+		*/
+		handle.resume();
+		return !handle.done();
+	}
+
+	int next_time() {
+		/*
+			Function Name: next_time
+			Arguments: void
+			Returns: int
+			Description: gives the time at which the device has to be resumed
+		*/
+		return handle.promise().next_time;
+	}
+
+	void destroy() {
+		/*
+			Function Name: destroy
+			Arguments: void
+			Returns: void
+			Description: frees the frame of the coroutine
+		*/
+		if(handle) {
+			handle.destroy();
+			handle = NULL;
+		}
+	}
+};
+
+#endif
+
+#ifndef DEVICE_CONTEXT_H
+#define DEVICE_CONTEXT_H
+
+class DeviceContext {
+	/*
+		Class Name: DeviceContext
+		Description: simulation state of one device while it is not running. The running device keeps its
+			state in the thread local globals of simulate.cpp and swaps it back here when it suspends.
+	*/
+public:
+	int index; // index of the device
+	std::list<Request*> requests; // requests of the device in arrival order
+	std::list<Request*>::iterator next_arrival;
+	bool all_arrived; // whether next_arrival is at end of requests
+	int curr_time;
+	int curr_head_location;
+	unsigned int arrived_count;
+	unsigned int completed_count;
+	WriteBackCache *write_cache;
+	Summary summary;
+
+	/*************************** Constructor ***************************/
+	DeviceContext(int index) {
+		this->index = index;
+		all_arrived = false;
+		curr_time = 0;
+		curr_head_location = 0;
+		arrived_count = 0;
+		completed_count = 0;
+		write_cache = NULL;
+	}
+};
+
+#endif
@@ -3,19 +3,70 @@
 	Description: Entry point of program. Acts as the controller for the program
 */
 #include <unistd.h>
+#include <getopt.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <list>
+#include "data_structures.h"
 
 /*************************** imported from readinput.cpp ***************************/
-extern void readInput(char *filename);
+extern bool readInput(char *filename);
 
 /*************************** imported from simulate.cpp ***************************/
 extern void simulate();
 
+/*************************** imported from montecarlo.cpp ***************************/
+extern bool parse_workload_params(char *spec, WorkloadParams *params);
+extern void run_monte_carlo(WorkloadParams *params, char *algos, int runs, int threads);
+
+/*************************** imported from multidevice.cpp ***************************/
+extern void run_multi_device(int num_devices, int threads, char algo, WorkloadParams *params);
+
 
 /**************************** Global Variables ****************************/
 char algo; //holds the algorithm to be implemented
+char *algos = (char*)"i"; // all algorithms given with -s, compared in monte carlo mode
 bool verbose; //whether verbose option is selected or not
 bool print_queue; //whether to print IO queue
+int cache_capacity; // capacity of write-back cache, 0 means cache is disabled
+int cache_high_watermark; // dirty writes at which cache starts flushing
+int cache_low_watermark; // dirty writes at which cache stops flushing
+bool quiet; // suppresses logging from inside a run, set when many runs are simulated
+int mc_runs; // number of random workloads in monte carlo mode, 0 means a trace file is simulated
+int num_threads; // worker threads for monte carlo and multi device mode, 0 means all cores
+int num_devices; // number of devices simulated together, 0 means a single device
+WorkloadParams workload_params; // distribution of random workloads
+char *telemetry_file; // csv file to which time series of the run is written, NULL if disabled
+int telemetry_interval = 100; // ticks per telemetry sample
+char *checkpoint_file; // file to which checkpoints are written, NULL if disabled
+char *trace_file; // input file of a single device run, a checkpoint is only resumed with the same file
+int checkpoint_interval = 1000000; // ticks between two checkpoints
+bool resume; // whether to continue from the checkpoint in checkpoint_file
+bool ssd; // whether the device is an ssd instead of a disk
+int ssd_channels; // independent channels of ssd
+int ssd_read_time, ssd_write_time; // ticks taken by a read and a write on a channel
+bool ssd_channel_aware; // whether ssd dispatches past requests blocked on a busy channel
+char result_format = 't'; // format of per request results, 't' text, 'c' csv or 'b' binary
+char *result_file; // file to which per request results are written, NULL for standard output
+DiskGeometry *geometry; // zoned geometry of disk which maps lba of requests to cylinders, NULL if disabled
+int anticipation_window; // ticks the head waits after a completion for a nearby request, 0 means disabled
+int anticipation_distance = 8; // tracks within which a request counts as nearby
+bool replay; // whether only a window of the trace is simulated
+int replay_from; // start of window, simulation starts at this tick
+int replay_to = INT_MAX; // end of window, requests arriving at or after it are not read
+int replay_warmup; // ticks before the window which are simulated to bring the queue to its state at the window start
+
+/**************************** Long Options ****************************/
+static struct option long_options[] = {
+	{"checkpoint", required_argument, NULL, 'k'},
+	{"checkpoint-interval", required_argument, NULL, 'K'},
+	{"resume", no_argument, NULL, 'r'},
+	{"from", required_argument, NULL, 'F'},
+	{"to", required_argument, NULL, 'U'},
+	{"warmup", required_argument, NULL, 'P'},
+	{NULL, 0, NULL, 0}
+};
 
 int main(int argc, char *argv[]) {
 	/*
@@ -29,11 +80,14 @@ int main(int argc, char *argv[]) {
 	
 	int opt; //option character in command line argument
 
-	while((opt = getopt(argc, argv, "qvs:")) != -1) {
+	while((opt = getopt_long(argc, argv, "qvs:w:m:g:j:t:T:k:K:rd:o:n:G:A:F:U:P:", long_options, NULL)) != -1) {
 		switch(opt) {
 		//get the scheduler algorithm to be implemented
 		case 's':
-			if(optarg != NULL) algo = optarg[0];
+			if(optarg != NULL) {
+				algo = optarg[0];
+				algos = optarg;
+			}
 			break;
 		case 'v':
 			verbose = true;
@@ -41,14 +95,195 @@ int main(int argc, char *argv[]) {
 		case 'q':
 			print_queue=true;
 			break;
+		// enable write-back cache given as capacity[:high[:low]]
+		case 'w':
+			cache_high_watermark = cache_low_watermark = -1;
+			sscanf(optarg, "%d:%d:%d", &cache_capacity, &cache_high_watermark, &cache_low_watermark);
+			if(cache_high_watermark < 0) cache_high_watermark = cache_capacity;
+			if(cache_low_watermark < 0) cache_low_watermark = cache_high_watermark / 2;
+			if(cache_capacity <= 0 || cache_high_watermark > cache_capacity || cache_low_watermark >= cache_high_watermark) {
+				printf("Invalid write cache configuration\n");
+				return 1;
+			}
+			break;
+		// run monte carlo experiment over given number of random workloads
+		case 'm':
+			mc_runs = atoi(optarg);
+			break;
+		// distribution of random workloads as key=value pairs
+		case 'g':
+			if(!parse_workload_params(optarg, &workload_params)) {
+				printf("Invalid workload parameters\n");
+				return 1;
+			}
+			break;
+		case 'j':
+			num_threads = atoi(optarg);
+			break;
+		// write time series of queue depth, head position, completions and wait to file
+		case 't':
+			telemetry_file = optarg;
+			break;
+		case 'T':
+			telemetry_interval = atoi(optarg);
+			if(telemetry_interval <= 0) {
+				printf("Invalid telemetry interval\n");
+				return 1;
+			}
+			break;
+		// take checkpoints of the simulation, and resume from the last one
+		case 'k':
+			checkpoint_file = optarg;
+			break;
+		case 'K':
+			checkpoint_interval = atoi(optarg);
+			if(checkpoint_interval <= 0) {
+				printf("Invalid checkpoint interval\n");
+				return 1;
+			}
+			break;
+		case 'r':
+			resume = true;
+			break;
+		// device given as disk or ssd:channels:read_time:write_time[:aware]
+		case 'd':
+			if(strncmp(optarg, "ssd", 3) == 0) {
+				ssd = true;
+				ssd_channels = 8;
+				ssd_read_time = 1;
+				ssd_write_time = 4;
+				sscanf(optarg, "ssd:%d:%d:%d", &ssd_channels, &ssd_read_time, &ssd_write_time);
+				ssd_channel_aware = strstr(optarg, ":aware") != NULL;
+				if(ssd_channels <= 0 || ssd_read_time <= 0 || ssd_write_time <= 0) {
+					printf("Invalid ssd configuration\n");
+					return 1;
+				}
+			} else if(strcmp(optarg, "disk") == 0) {
+				ssd = false;
+			} else {
+				printf("Invalid device\n");
+				return 1;
+			}
+			break;
+		// write per request results to a file as text:file, csv:file or bin:file
+		case 'o':
+			if(strncmp(optarg, "text:", 5) == 0) {
+				result_format = 't';
+			} else if(strncmp(optarg, "csv:", 4) == 0) {
+				result_format = 'c';
+			} else if(strncmp(optarg, "bin:", 4) == 0) {
+				result_format = 'b';
+			} else {
+				printf("Invalid result output\n");
+				return 1;
+			}
+			result_file = strchr(optarg, ':') + 1;
+			break;
+		// simulate many devices together
+		case 'n':
+			num_devices = atoi(optarg);
+			break;
+		// disk geometry given as cylinders:heads:zones:outer:inner:revolution[:tick_us]
+		case 'G':
+			geometry = new DiskGeometry();
+			sscanf(optarg, "%d:%d:%d:%d:%d:%d:%d", &geometry->cylinders, &geometry->heads, &geometry->zones,
+				&geometry->outer_sectors, &geometry->inner_sectors, &geometry->revolution_ticks, &geometry->tick_us);
+			if(!geometry->is_valid()) {
+				printf("Invalid disk geometry\n");
+				return 1;
+			}
+			break;
+		// anticipation around the scheduler given as window[:distance]
+		case 'A':
+			sscanf(optarg, "%d:%d", &anticipation_window, &anticipation_distance);
+			if(anticipation_window <= 0 || anticipation_distance < 0) {
+				printf("Invalid anticipation\n");
+				return 1;
+			}
+			break;
+		// replay only the window [from, to) of the trace
+		case 'F':
+			replay = true;
+			replay_from = atoi(optarg);
+			break;
+		case 'U':
+			replay = true;
+			replay_to = atoi(optarg);
+			break;
+		case 'P':
+			replay = true;
+			replay_warmup = atoi(optarg);
+			break;
 		default:
 			printf("Invalid Option\n");
 		}
 	}
 
+	// anticipation relies on the device serving one request at a time, which only the disk does
+	if(anticipation_window > 0 && ssd) {
+		printf("Anticipation needs the disk device\n");
+		return 1;
+	}
+
+	if(replay && (replay_from < 0 || replay_to <= replay_from || replay_warmup < 0)) {
+		printf("Invalid replay window\n");
+		return 1;
+	}
+
+	// in monte carlo mode workloads are generated in memory and no input file is read
+	if(mc_runs > 0) {
+		replay = false;
+		replay_from = 0;
+		replay_warmup = 0;
+		quiet = true;
+		checkpoint_file = NULL;
+		resume = false;
+		verbose = false;
+		print_queue = false;
+		run_monte_carlo(&workload_params, algos, mc_runs, num_threads);
+		return 0;
+	}
+
+	// in multi device mode requests of the input file are striped over the devices,
+	// without an input file every device gets its own random workload
+	if(num_devices > 0) {
+		quiet = true;
+		checkpoint_file = NULL;
+		resume = false;
+		telemetry_file = NULL;
+		verbose = false;
+		print_queue = false;
+		if(optind < argc) {
+			if(!readInput(argv[optind])) {
+				return 1;
+			}
+			run_multi_device(num_devices, num_threads, algo, NULL);
+		} else {
+			replay = false;
+			replay_from = 0;
+			replay_warmup = 0;
+			run_multi_device(num_devices, num_threads, algo, &workload_params);
+		}
+		return 0;
+	}
+
+
+	if(resume && checkpoint_file == NULL) {
+		printf("--resume needs --checkpoint file\n");
+		return 1;
+	}
+
+	// the lines of -v and -q are not kept in the log of the checkpoint, so a resumed run could not repeat them
+	if(checkpoint_file != NULL && (verbose || print_queue)) {
+		printf("--checkpoint cannot be combined with -v or -q\n");
+		return 1;
+	}
 
 	// read the input file and store all IO requests in requests list
-	readInput(argv[optind]);
+	trace_file = argv[optind];
+	if(!readInput(trace_file)) {
+		return 1;
+	}
 
 	// simulate the IO requests
 	simulate();
@@ -0,0 +1,274 @@
+/*
+	Module Name: montecarlo.cpp
+	Description: Generates random workloads in memory, simulates them on all cores and reports
+		the mean and 95% confidence interval of every summary metric.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <list>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include "data_structures.h"
+
+/*************************** imported from main.cpp ***************************/
+extern int cache_capacity;
+extern bool ssd;
+
+/*************************** imported from simulate.cpp ***************************/
+extern thread_local std::list<Request*> requests;
+extern void run_simulation(char algo, Summary *summary);
+extern int shadow_movement(char algo, bool cache, bool anticipation);
+
+
+/*************************** function declarations ***************************/
+void generate_workload(WorkloadParams *params, int index);
+void free_workload();
+void monte_carlo_worker(WorkloadParams *params, char *algos, int runs, std::atomic<int> *next_run, std::vector<Summary> *results);
+void print_confidence_interval(std::vector<double> &samples);
+double get_t_value(int degrees_of_freedom);
+
+
+bool parse_workload_params(char *spec, WorkloadParams *params) {
+	/*
+		Function Name: parse_workload_params
+		Arguments: char *spec: comma separated key=value pairs, WorkloadParams *params: filled with the values
+		Returns: bool: false if spec has an unknown key
+		Description: parses the workload distribution given on command line
+	*/
+	char key[32];
+	double value;
+	char *pair = strtok(spec, ",");
+	while(pair != NULL) {
+		if(sscanf(pair, "%31[^=]=%lf", key, &value) != 2) {
+			return false;
+		}
+		if(strcmp(key, "n") == 0) {
+			params->num_requests = (int)value;
+		} else if(strcmp(key, "gap") == 0) {
+			params->mean_gap = value;
+		} else if(strcmp(key, "tracks") == 0) {
+			params->max_track = (int)value;
+		} else if(strcmp(key, "hot") == 0) {
+			params->hot_fraction = value;
+		} else if(strcmp(key, "seq") == 0) {
+			params->seq_fraction = value;
+		} else if(strcmp(key, "burst") == 0) {
+			params->burst_prob = value;
+		} else if(strcmp(key, "burstlen") == 0) {
+			params->mean_burst_len = value;
+		} else if(strcmp(key, "writes") == 0) {
+			params->write_fraction = value;
+		} else if(strcmp(key, "seed") == 0) {
+			params->seed = (unsigned int)value;
+		} else {
+			return false;
+		}
+		pair = strtok(NULL, ",");
+	}
+	return params->num_requests > 0 && params->max_track > 0 && params->mean_gap > 0;
+}
+
+
+void run_monte_carlo(WorkloadParams *params, char *algos, int runs, int threads) {
+	/*
+		Function Name: run_monte_carlo
+		Arguments: WorkloadParams *params: workload distribution, char *algos: algorithms to be compared,
+			int runs: number of workloads, int threads: number of worker threads, 0 for all cores
+		Returns: void
+		Description: simulates runs random workloads with each algorithm and prints mean and 95% confidence
+			interval of every metric of the SUM line, one line per algorithm
+	*/
+	int num_algos = strlen(algos);
+	std::vector<Summary> results(num_algos * runs);
+	std::atomic<int> next_run(0);
+	std::vector<std::thread> workers;
+
+	if(threads <= 0) {
+		threads = std::thread::hardware_concurrency();
+		if(threads <= 0) {
+			threads = 1;
+		}
+	}
+
+	// workers pick up workloads one at a time, results are stored by workload index
+	// so that output does not depend on number of threads or their interleaving
+	for(int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(monte_carlo_worker, params, algos, runs, &next_run, &results));
+	}
+	for(int i = 0; i < threads; i++) {
+		workers[i].join();
+	}
+
+	printf("MC: %d %d %d\n", runs, params->num_requests, threads);
+	for(int a = 0; a < num_algos; a++) {
+		std::vector<double> total_time, tot_movement, turnaround, wait, max_wait;
+		std::vector<double> read_latency, write_ack_latency, writeback_movement, saved_movement;
+		bool has_writes = false;
+		for(int k = 0; k < runs; k++) {
+			Summary *summary = &results[a * runs + k];
+			total_time.push_back(summary->total_time);
+			tot_movement.push_back(summary->tot_movement);
+			turnaround.push_back(summary->avg_turnaround_time);
+			wait.push_back(summary->avg_wait_time);
+			max_wait.push_back(summary->max_wait_time);
+			read_latency.push_back(summary->avg_read_latency);
+			write_ack_latency.push_back(summary->avg_write_ack_latency);
+			writeback_movement.push_back(summary->writeback_movement);
+			saved_movement.push_back(summary->saved_movement);
+			has_writes = has_writes || summary->has_writes;
+		}
+
+		printf("SUM: %c", algos[a]);
+		print_confidence_interval(total_time);
+		print_confidence_interval(tot_movement);
+		print_confidence_interval(turnaround);
+		print_confidence_interval(wait);
+		print_confidence_interval(max_wait);
+		printf("\n");
+
+		if(cache_capacity > 0 || has_writes) {
+			printf("RW: %c", algos[a]);
+			print_confidence_interval(read_latency);
+			print_confidence_interval(write_ack_latency);
+			print_confidence_interval(writeback_movement);
+			print_confidence_interval(saved_movement);
+			printf("\n");
+		}
+	}
+}
+
+
+void monte_carlo_worker(WorkloadParams *params, char *algos, int runs, std::atomic<int> *next_run, std::vector<Summary> *results) {
+	/*
+		Function Name: monte_carlo_worker
+		Arguments: WorkloadParams *params, char *algos, int runs, std::atomic<int> *next_run: index of next workload
+			to be picked up, std::vector<Summary> *results: summaries indexed by algorithm and workload
+		Returns: void
+		Description: body of a worker thread, generates workloads and simulates them with every algorithm
+	*/
+	int num_algos = strlen(algos);
+	int k;
+	while((k = (*next_run)++) < runs) {
+		for(int a = 0; a < num_algos; a++) {
+			// the workload is regenerated for every algorithm as simulation changes the requests
+			generate_workload(params, k);
+			Summary *summary = &(*results)[a * runs + k];
+			int movement_without_cache = 0;
+			if(cache_capacity > 0 && !ssd) {
+				movement_without_cache = shadow_movement(algos[a], false, true);
+			}
+			run_simulation(algos[a], summary);
+			if(cache_capacity > 0 && !ssd) {
+				summary->saved_movement = movement_without_cache - summary->tot_movement;
+			}
+			free_workload();
+		}
+	}
+}
+
+
+void generate_workload(WorkloadParams *params, int index) {
+	/*
+		Function Name: generate_workload
+		Arguments: WorkloadParams *params: distribution to draw from, int index: index of the workload
+		Returns: void
+		Description: fills the requests list with a random workload. Every workload has its own
+			random stream seeded by base seed and index, so it is the same on whichever thread it runs.
+	*/
+	std::seed_seq seq{params->seed, (unsigned int)index};
+	std::mt19937_64 rng(seq);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::exponential_distribution<double> gap(1.0 / params->mean_gap);
+	std::uniform_int_distribution<int> track(0, params->max_track - 1);
+	std::uniform_int_distribution<int> hot_track(0, (params->max_track - 1) / 10);
+
+	int arrival_time = 0, prev_track = 0, burst_left = 0;
+	for(int i = 0; i < params->num_requests; i++) {
+		// arrivals inside a burst come back to back, otherwise they are poisson
+		if(burst_left > 0) {
+			arrival_time += 1;
+			burst_left--;
+		} else {
+			arrival_time += 1 + (int)gap(rng);
+			if(uniform(rng) < params->burst_prob) {
+				burst_left = (int)(uniform(rng) * 2 * params->mean_burst_len);
+			}
+		}
+
+		int track_required;
+		double draw = uniform(rng);
+		if(i > 0 && draw < params->seq_fraction && prev_track + 1 < params->max_track) {
+			track_required = prev_track + 1;
+		} else if(draw < params->seq_fraction + params->hot_fraction) {
+			track_required = hot_track(rng);
+		} else {
+			track_required = track(rng);
+		}
+		prev_track = track_required;
+
+		bool is_write = uniform(rng) < params->write_fraction;
+		requests.push_back(new Request(i, arrival_time, track_required, CREATED, is_write));
+	}
+}
+
+
+void free_workload() {
+	/*
+		Function Name: free_workload
+		Arguments: void
+		Returns: void
+		Description: deletes all the requests of the requests list
+	*/
+	std::list<Request*>::iterator it;
+	for(it = requests.begin(); it != requests.end(); ++it) {
+		delete (*it);
+	}
+	requests.clear();
+}
+
+
+void print_confidence_interval(std::vector<double> &samples) {
+	/*
+		Function Name: print_confidence_interval
+		Arguments: std::vector<double> &samples
+		Returns: void
+		Description: prints mean of the samples and half width of its 95% confidence interval
+	*/
+	int n = samples.size();
+	double mean = 0, variance = 0, half_width = 0;
+	for(int i = 0; i < n; i++) {
+		mean += samples[i];
+	}
+	mean = mean / n;
+	if(n > 1) {
+		for(int i = 0; i < n; i++) {
+			variance += (samples[i] - mean) * (samples[i] - mean);
+		}
+		variance = variance / (n - 1);
+		half_width = get_t_value(n - 1) * sqrt(variance / n);
+	}
+	printf(" %.2lf +-%.2lf", mean, half_width);
+}
+
+
+double get_t_value(int degrees_of_freedom) {
+	/*
+		Function Name: get_t_value
+		Arguments: int degrees_of_freedom
+		Returns: double
+		Description: gives the two sided 95% critical value of student's t distribution,
+			normal approximation is used beyond 30 degrees of freedom
+	*/
+	static const double t_values[30] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	if(degrees_of_freedom <= 30) {
+		return t_values[degrees_of_freedom - 1];
+	}
+	return 1.960;
+}
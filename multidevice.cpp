@@ -0,0 +1,252 @@
+/*
+	Module Name: multidevice.cpp
+	Description: Simulates many devices in one process. Every device is a coroutine which yields at its next
+		event, a single threaded event loop resumes the device with the earliest event. Groups of devices
+		can be sharded over worker threads, each running its own event loop.
+*/
+#include <stdio.h>
+#include <list>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <functional>
+#include "data_structures.h"
+
+/*************************** imported from main.cpp ***************************/
+extern char result_format;
+extern char *result_file;
+extern int replay_from;
+
+/*************************** imported from simulate.cpp ***************************/
+extern thread_local std::list<Request*> requests;
+extern thread_local std::list<Request*>::iterator next_arrival;
+extern thread_local unsigned int arrived_count;
+extern thread_local unsigned int completed_count;
+extern thread_local WriteBackCache *write_cache;
+extern bool is_request_active();
+extern void start_simulation(char algo, Scheduler **sched, Device **device);
+extern void simulate_tick(Scheduler *sched, Device *device);
+extern int next_event_time(Scheduler *sched, Device *device);
+extern void end_simulation(Scheduler *sched, Device *device, Summary *summary);
+
+/*************************** imported from montecarlo.cpp ***************************/
+extern void generate_workload(WorkloadParams *params, int index);
+extern void free_workload();
+
+
+/*************************** function declarations ***************************/
+void switch_in(DeviceContext *context);
+void switch_out(DeviceContext *context);
+DeviceTask simulate_device(DeviceContext *context, char algo, WorkloadParams *params);
+void run_event_loop(std::vector<DeviceContext*> *contexts, int first, int last, char algo, WorkloadParams *params);
+
+
+void run_multi_device(int num_devices, int threads, char algo, WorkloadParams *params) {
+	/*
+		Function Name: run_multi_device
+		Arguments: int num_devices, int threads: worker threads, 0 for all cores, char algo,
+			WorkloadParams *params: distribution of per device workloads, NULL if requests list is striped
+		Returns: void
+		Description: simulates num_devices devices and prints the summary of each device and of all of them.
+			Requests read from the input are striped over devices, otherwise every device gets its own
+			random workload which is freed as soon as the device is done.
+	*/
+	std::vector<DeviceContext*> contexts;
+	std::vector<std::thread> workers;
+	std::list<Request*>::iterator it;
+	int i = 0;
+
+	for(int d = 0; d < num_devices; d++) {
+		contexts.push_back(new DeviceContext(d));
+	}
+	if(params == NULL) {
+		for(it = requests.begin(); it != requests.end(); ++it, i++) {
+			contexts[i % num_devices]->requests.push_back(*it);
+		}
+	}
+
+	if(threads <= 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	if(threads > num_devices) {
+		threads = num_devices;
+	}
+	if(threads <= 1) {
+		run_event_loop(&contexts, 0, num_devices, algo, params);
+		threads = 1;
+	} else {
+		// every thread gets a contiguous group of devices
+		for(int t = 0; t < threads; t++) {
+			int first = (long long)num_devices * t / threads;
+			int last = (long long)num_devices * (t + 1) / threads;
+			workers.push_back(std::thread(run_event_loop, &contexts, first, last, algo, params));
+		}
+		for(int t = 0; t < threads; t++) {
+			workers[t].join();
+		}
+	}
+
+	// results of the requests from the input in their original order
+	if(params == NULL) {
+		FILE *results = stdout;
+		if(result_file != NULL) {
+			results = fopen(result_file, "wb");
+		}
+		if(results == NULL) {
+			printf("Unable to open result file %s\n", result_file);
+		} else {
+			fflush(stdout);
+			ResultWriter *writer = new ResultWriter(results, result_format);
+			for(it = requests.begin(); it != requests.end(); ++it) {
+				if((*it)->arrival_time >= replay_from) {
+					writer->write(*it);
+				}
+			}
+			delete writer;
+			if(results != stdout) {
+				fclose(results);
+			}
+		}
+	}
+
+	// summary of every device and then of all of them, averages weighted by requests of each device
+	long long tot_movement = 0, num_requests = 0;
+	double turn_around_time = 0, wait_time = 0;
+	int total_time = 0, max_wait_time = 0;
+	printf("DEVICES: %d %d\n", num_devices, threads);
+	for(int d = 0; d < num_devices; d++) {
+		Summary *summary = &contexts[d]->summary;
+		int count = summary->requests;
+		printf("DEV: %d %d %d %.2lf %.2lf %d\n", d, summary->total_time, summary->tot_movement,
+			summary->avg_turnaround_time, summary->avg_wait_time, summary->max_wait_time);
+		if(count == 0) {
+			continue;
+		}
+		if(summary->total_time > total_time) total_time = summary->total_time;
+		if(summary->max_wait_time > max_wait_time) max_wait_time = summary->max_wait_time;
+		tot_movement += summary->tot_movement;
+		turn_around_time += summary->avg_turnaround_time * count;
+		wait_time += summary->avg_wait_time * count;
+		num_requests += count;
+	}
+	if(num_requests > 0) {
+		turn_around_time = turn_around_time / num_requests;
+		wait_time = wait_time / num_requests;
+	}
+	printf("SUM: %d %lld %.2lf %.2lf %d\n", total_time, tot_movement, turn_around_time, wait_time, max_wait_time);
+
+	for(int d = 0; d < num_devices; d++) {
+		delete contexts[d];
+	}
+}
+
+
+void run_event_loop(std::vector<DeviceContext*> *contexts, int first, int last, char algo, WorkloadParams *params) {
+	/*
+		Function Name: run_event_loop
+		Arguments: std::vector<DeviceContext*> *contexts, int first, int last: devices [first, last) to simulate,
+			char algo, WorkloadParams *params
+		Returns: void
+		Description: event loop which always resumes the device with the earliest next event until all are done
+	*/
+	std::vector<DeviceTask> tasks;
+	// earliest (time, task) first, ties resumed in order of device
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > events;
+
+	tasks.reserve(last - first);
+	for(int d = first; d < last; d++) {
+		tasks.push_back(simulate_device((*contexts)[d], algo, params));
+		events.push(std::make_pair(0, d - first));
+	}
+
+	while(!events.empty()) {
+		int task = events.top().second;
+		events.pop();
+		if(tasks[task].resume()) {
+			events.push(std::make_pair(tasks[task].next_time(), task));
+		} else {
+			tasks[task].destroy();
+		}
+	}
+}
+
+
+DeviceTask simulate_device(DeviceContext *context, char algo, WorkloadParams *params) {
+	/*
+		Function Name: simulate_device
+		Arguments: DeviceContext *context: state of the device, char algo,
+			WorkloadParams *params: distribution of workload of the device, NULL if its requests are given
+		Returns: DeviceTask: coroutine of the device
+		Description: simulates the device like run_simulation but yields whenever it reaches a tick at which
+			something happens, ticks in between are skipped as only the head moves in them
+	*/
+	Scheduler *sched = NULL;
+	Device *device = NULL;
+
+	switch_in(context);
+	if(params != NULL) {
+		generate_workload(params, context->index);
+	}
+	start_simulation(algo, &sched, &device);
+
+	while(is_request_active()) {
+		simulate_tick(sched, device);
+		curr_time++;
+		if(!is_request_active()) {
+			break;
+		}
+
+		// skip to the next event, the device stays on current time if it has none
+		int next = next_event_time(sched, device);
+		if(next != INT_MAX && next > curr_time) {
+			device->advance(next - curr_time);
+			curr_time = next;
+		}
+
+		switch_out(context);
+		co_yield curr_time;
+		switch_in(context);
+	}
+
+	end_simulation(sched, device, &context->summary);
+	if(params != NULL) {
+		free_workload();
+	}
+	switch_out(context);
+}
+
+
+void switch_in(DeviceContext *context) {
+	/*
+		Function Name: switch_in
+		Arguments: DeviceContext *context
+		Returns: void
+		Description: loads the state of the device into the globals of simulation
+	*/
+	requests.swap(context->requests);
+	next_arrival = context->all_arrived ? requests.end() : context->next_arrival;
+	curr_time = context->curr_time;
+	curr_head_location = context->curr_head_location;
+	arrived_count = context->arrived_count;
+	completed_count = context->completed_count;
+	write_cache = context->write_cache;
+}
+
+
+void switch_out(DeviceContext *context) {
+	/*
+		Function Name: switch_out
+		Arguments: DeviceContext *context
+		Returns: void
+		Description: saves the globals of simulation into the state of the device
+	*/
+	// end of list is not carried over by swap, so it is remembered as a flag
+	context->all_arrived = next_arrival == requests.end();
+	context->next_arrival = next_arrival;
+	context->curr_time = curr_time;
+	context->curr_head_location = curr_head_location;
+	context->arrived_count = arrived_count;
+	context->completed_count = completed_count;
+	context->write_cache = write_cache;
+	requests.swap(context->requests);
+}
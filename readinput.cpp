@@ -8,35 +8,118 @@
 #include <list>
 #include "data_structures.h"
 
+#define DEFAULT_REQUEST_SIZE 8 // sectors of a request whose trace line has no size
+
+/*************************** imported from main.cpp ***************************/
+extern DiskGeometry *geometry;
+extern bool replay;
+extern int replay_from, replay_to, replay_warmup;
+
+/*************************** imported from traceindex.cpp ***************************/
+extern bool open_trace_index(char *filename, TraceIndex *index);
+
 /*************************** imported from simulate.cpp ***************************/
-extern std::list<Request*> requests;
+extern thread_local std::list<Request*> requests;
+
+int first_request_id; // id in the whole trace of the first request read, requests are numbered from it in the output
 
 
-void readInput(char *filename) {
+bool readInput(char *filename) {
 	/*
 		Function Name: readInput
 		Arguments: char *filename: path to input file
-		Returns: void
-		Description: reads input from file specified and initializes requests list
+		Returns: bool: false if a request has no sectors or lies beyond the disk geometry, or the trace cannot be indexed
+		Description: reads input from file specified and initializes requests list. With a geometry the second
+			column is the lba of the request, which is mapped to its cylinder and transfer time. In replay
+			mode only requests arriving in the window, and in the warmup before it, are read, starting
+			from the offset given by the trace index. Requests keep their position in what was read as id,
+			their id in the whole trace is first_request_id more.
 	*/
 	char *line = new char[100]; // buffer
 	int arrival_time, track_required;
+	long long lba;
+	char operation; // optional third column, 'R' for read and 'W' for write
+	int size; // optional fourth column, sectors transferred
+	int cylinder, head, sector, zone;
+	int start = 0; // arrival time of first request read
+	int warm = 0; // requests read which arrive before the window
 	std::fstream file;
 	int curr_req_id = 0;
 
 
 
+	first_request_id = 0;
+
 	// open file
-	file.open(filename, std::ios_base::in);
+	file.open(filename, std::ios_base::in | std::ios_base::binary);
+
+	// in replay mode seek to the interval of the trace in which reading starts
+	if(replay) {
+		TraceIndex index;
+		if(!open_trace_index(filename, &index)) {
+			printf("Unable to index trace %s\n", filename);
+			return false;
+		}
+		start = replay_from - replay_warmup;
+		if(start < 0) {
+			start = 0;
+		}
+		unsigned int entry = start / index.interval;
+		if(entry < index.offsets.size()) {
+			file.seekg(index.offsets[entry]);
+			first_request_id = index.ids[entry];
+		} else {
+			first_request_id = index.request_count;
+			file.setstate(std::ios_base::eofbit);
+		}
+	}
 
 	// read and process it
 	while(file.getline(line, 100)) {
 		if(strlen(line) == 0 || line[0] == '#') {
 			continue;
 		}
-		sscanf(line, "%d %d", &arrival_time, &track_required);
-		Request *request = new Request(curr_req_id, arrival_time, track_required, CREATED);
+		operation = 'R';
+		size = DEFAULT_REQUEST_SIZE;
+		sscanf(line, "%d %lld %c %d", &arrival_time, &lba, &operation, &size);
+		if(replay) {
+			if(arrival_time < start) {
+				first_request_id++;
+				continue;
+			}
+			if(arrival_time >= replay_to) {
+				break;
+			}
+			if(arrival_time < replay_from) {
+				warm++;
+			}
+		}
+		bool is_write = (operation == 'W' || operation == 'w');
+		if(size <= 0) {
+			printf("Size %d of request %d is not positive\n", size, first_request_id + curr_req_id);
+			return false;
+		}
+		track_required = lba;
+		if(geometry != NULL) {
+			if(!geometry->map(lba, &cylinder, &head, &sector, &zone)) {
+				printf("LBA %lld of request %d is beyond the disk\n", lba, first_request_id + curr_req_id);
+				return false;
+			}
+			track_required = cylinder;
+		}
+		Request *request = new Request(curr_req_id, arrival_time, track_required, CREATED, is_write);
+		request->lba = lba;
+		request->size = size;
+		if(geometry != NULL) {
+			request->transfer_time = geometry->transfer_time(zone, size);
+		}
 		requests.push_back(request);
 		curr_req_id++;
 	}
+	delete[] line;
+
+	if(replay) {
+		printf("REPLAY: %d %d %d\n", first_request_id, curr_req_id, warm);
+	}
+	return true;
 }
\ No newline at end of file
@@ -3,27 +3,66 @@
 	Description: Simulates the IO requests as per specified algorithm.
 */
 #include <stdio.h>	
+#include <stdlib.h>
 #include <list>
 #include "data_structures.h"
 
 /*************************** imported from main.cpp ***************************/
 extern char algo;
 extern bool verbose, print_queue;
-extern void print_request_list();
+extern int cache_capacity, cache_high_watermark, cache_low_watermark;
+extern char *telemetry_file;
+extern int telemetry_interval;
+extern char *checkpoint_file;
+extern int checkpoint_interval;
+extern bool resume;
+extern bool ssd;
+extern int ssd_channels, ssd_read_time, ssd_write_time;
+extern bool ssd_channel_aware;
+extern char result_format;
+extern char *result_file;
+extern DiskGeometry *geometry;
+extern int anticipation_window, anticipation_distance;
+extern int replay_from, replay_warmup;
+
+/*************************** imported from checkpoint.cpp ***************************/
+extern bool save_checkpoint(char *filename, char algo, Scheduler *sched, Device *device);
+extern bool load_checkpoint(char *filename, char algo, Scheduler *sched, Device *device);
+extern void log_completion(Request *request);
 
 
 /*************************** global variables ***************************/
-int curr_head_location;
-std::list<Request*> requests;
+// simulation state is thread local so that independent simulations can run on many threads
+thread_local int curr_head_location;
+thread_local int curr_time; // current time of simulation
+thread_local std::list<Request*> requests;
+thread_local std::list<Request*>::iterator next_arrival; // first request in list yet to arrive
+thread_local unsigned int arrived_count; // number of requests that have arrived so far
+thread_local unsigned int completed_count; // number of requests completed so far
+thread_local WriteBackCache *write_cache; // write-back cache of the device, NULL if disabled
+thread_local Telemetry *telemetry; // records time series of the run, NULL if disabled
+thread_local ResultWriter *result_writer; // writes result of every request at end of run, NULL if not needed
+thread_local bool shadow_run; // whether the run only measures head movement for comparison, which keeps it silent
+thread_local bool shadow_cache; // whether the write-back cache is kept in the shadow run
+thread_local bool shadow_anticipation; // whether anticipation is kept in the shadow run
 
 
 /*************************** function declarations ***************************/
+void run_simulation(char algo, Summary *summary);
+void start_simulation(char algo, Scheduler **sched, Device **device);
+void simulate_tick(Scheduler *sched, Device *device);
+int next_event_time(Scheduler *sched, Device *device);
+void end_simulation(Scheduler *sched, Device *device, Summary *summary);
+Scheduler* create_scheduler(char algo);
+Device* create_device();
+Request* fetch_request(Scheduler *sched);
+void issue_request(Request *request, int position);
 bool is_request_active();
 Request* new_request_arrived(int curr_time);
-void print_requests();
-double get_avg_turnaround_time();
-double get_avg_wait_time();
-int get_max_wait_time();
+void finish_request(Request *request, int curr_time);
+void flush_writes(WriteBackCache *write_cache, Scheduler *sched, int target, int curr_time);
+void finalize_results(Summary *summary);
+int shadow_movement(char algo, bool cache, bool anticipation);
 
 
 void simulate() {
@@ -31,227 +70,479 @@ void simulate() {
 		Function Name: simulate
 		Arguments: void
 		Returns: void
-		Description: simulates the IO requests as per specified scheduling algorithm.
+		Description: simulates the IO requests as per specified scheduling algorithm and prints the results.
+	*/
+	Summary summary;
+
+	if(telemetry_file != NULL) {
+		// on resume the rows written before the checkpoint are kept
+		FILE *file = fopen(telemetry_file, resume ? "r+" : "w");
+		if(file == NULL) {
+			printf("Unable to open telemetry file %s\n", telemetry_file);
+			return;
+		}
+		telemetry = new Telemetry(file, telemetry_interval, !resume);
+	}
+
+	// the requests and their corresponding information are written while the run is finalized
+	FILE *results = stdout;
+	if(result_file != NULL) {
+		results = fopen(result_file, "wb");
+		if(results == NULL) {
+			printf("Unable to open result file %s\n", result_file);
+			return;
+		}
+	}
+	fflush(stdout);
+	result_writer = new ResultWriter(results, result_format);
+
+	// what the cache and anticipation save is measured against runs without them, before the requests are changed
+	int movement_without_cache = 0, movement_without_anticipation = 0;
+	if(cache_capacity > 0 && !ssd) {
+		movement_without_cache = shadow_movement(algo, false, true);
+	}
+	if(anticipation_window > 0) {
+		movement_without_anticipation = shadow_movement(algo, true, false);
+	}
+
+	run_simulation(algo, &summary);
+	if(cache_capacity > 0 && !ssd) {
+		summary.saved_movement = movement_without_cache - summary.tot_movement;
+	}
+
+	delete result_writer;
+	result_writer = NULL;
+	if(results != stdout) {
+		fclose(results);
+	}
+	if(telemetry != NULL) {
+		delete telemetry;
+		telemetry = NULL;
+	}
+
+	// print the summary
+	printf("SUM: %d %d %.2lf %.2lf %d\n", summary.total_time, summary.tot_movement, summary.avg_turnaround_time, summary.avg_wait_time, summary.max_wait_time);
+
+	// print the read/write summary if trace has writes or cache is enabled
+	if(cache_capacity > 0 || summary.has_writes) {
+		printf("RW: %.2lf %.2lf %d %d %d\n", summary.avg_read_latency, summary.avg_write_ack_latency, summary.flushes,
+			summary.writeback_movement, summary.saved_movement);
+	}
+
+	// print the channel summary of ssd
+	if(summary.channels > 0) {
+		printf("SSD: %d %.2lf %d\n", summary.channels, summary.channel_utilization, summary.blocked_ticks);
+	}
+
+	// print how often anticipation paid off
+	if(anticipation_window > 0) {
+		summary.anticipation_saved = movement_without_anticipation - summary.tot_movement;
+		printf("ANTIC: %d %d %.2lf %d\n", summary.anticipations, summary.anticipation_hits,
+			summary.anticipations > 0 ? (double)summary.anticipation_hits / summary.anticipations : 0, summary.anticipation_saved);
+	}
+
+	// print the throughput of disk with geometry, bytes per microsecond is MB/s
+	if(geometry != NULL) {
+		double megabytes = summary.bytes / 1e6;
+		double seconds = (double)(summary.total_time - replay_from) * geometry->tick_us / 1e6;
+		printf("GEO: %.2lf %.2lf %.2lf\n", megabytes, seconds > 0 ? megabytes / seconds : 0, summary.avg_transfer_time);
+	}
+}
+
+void run_simulation(char algo, Summary *summary) {
+	/*
+		Function Name: run_simulation
+		Arguments: char algo: scheduling algorithm, Summary *summary: filled with the results
+		Returns: void
+		Description: simulates the IO requests in requests list as per specified scheduling algorithm.
 	*/
 
 	// variables for storing state and info of simulation
-	int curr_time = 0, tot_movement = 0;
-	Request *curr_request = NULL;
 	Scheduler *sched = NULL;
+	Device *device = NULL;
 
-	// select scheduler as per option specified
-	if(algo == 'i') {
-		sched = new FIFOScheduler();
-	} else if(algo == 'j') {
-		sched = new SSTFScheduler();
-	} else if(algo == 's') {
-		sched = new LookScheduler();
-	} else if(algo == 'c') {
-		sched = new CLookScheduler();
-	} else if(algo == 'f') {
-		sched = new FLookScheduler();
+	start_simulation(algo, &sched, &device);
+
+	// continue from where the checkpoint was taken
+	if(resume && !shadow_run && !load_checkpoint(checkpoint_file, algo, sched, device)) {
+		printf("Unable to resume from checkpoint %s\n", checkpoint_file);
+		exit(1);
 	}
 
 
 	// start simulation
 	// if there is any active request in request list then keep on simulating
 	while(is_request_active()) { 
-		// check whether new request has arrived
-		Request *request = new_request_arrived(curr_time);
-
-		// if yes then add it to IO queue
-		if(request != NULL) {
-			if(verbose)
-				printf("%d: %d add %d\n", curr_time, request->request_id, request->track_required);
-			sched->add_request(request);
-			request->state = READY;
+		// periodically take checkpoint of the state at start of the tick
+		if(checkpoint_file != NULL && !shadow_run && curr_time > 0 && curr_time % checkpoint_interval == 0) {
+			if(!save_checkpoint(checkpoint_file, algo, sched, device)) {
+				printf("Unable to write checkpoint %s\n", checkpoint_file);
+				exit(1);
+			}
 		}
 
-		// if any request is running currently then do its processing
-		if(curr_request != NULL) {
+		simulate_tick(sched, device);
 
-			// if header is away from the track required then move it accordingly
-			if(curr_head_location < curr_request->track_required) {
-				curr_head_location++;
-				tot_movement++;
-			} else if(curr_head_location > curr_request->track_required) {
-				curr_head_location--;
-				tot_movement++;
-			}
+		// finally increment the time
+		curr_time++;
+	}
+
+	// record the last partial window
+	if(telemetry != NULL) {
+		telemetry->write_row(curr_time - 1, 0);
+	}
+
+	end_simulation(sched, device, summary);
+}
+
+void start_simulation(char algo, Scheduler **sched, Device **device) {
+	/*
+		Function Name: start_simulation
+		Arguments: char algo: scheduling algorithm, Scheduler **sched, Device **device: created for the run
+		Returns: void
+		Description: resets the state of simulation for the requests in requests list, starting at the
+			beginning of the warmup before the replay window
+	*/
+	curr_time = replay_from - replay_warmup > 0 ? replay_from - replay_warmup : 0;
+	curr_head_location = 0;
+	next_arrival = requests.begin();
+	arrived_count = 0;
+	completed_count = 0;
+	write_cache = NULL;
+	if(cache_capacity > 0 && (!shadow_run || shadow_cache)) {
+		write_cache = new WriteBackCache(cache_capacity, cache_high_watermark, cache_low_watermark);
+	}
+
+	if(telemetry != NULL) {
+		telemetry->start(curr_time);
+	}
+
+	// select scheduler and device as per option specified
+	*sched = create_scheduler(algo);
+	if(anticipation_window > 0 && (!shadow_run || shadow_anticipation)) {
+		*sched = new AnticipatoryScheduler(*sched, anticipation_window, anticipation_distance);
+	}
+	*device = create_device();
+}
+
+void simulate_tick(Scheduler *sched, Device *device) {
+	/*
+		Function Name: simulate_tick
+		Arguments: Scheduler *sched, Device *device
+		Returns: void
+		Description: simulates the current tick, i.e. queues the requests arriving now and lets the device serve
+	*/
 
-			// if header is on the track required then fininsh the request
-			// also do the corresponding accounting calculations
-			if(curr_head_location == curr_request->track_required) {
-				curr_request->end_time = curr_time;
-				curr_request->turn_around_time = curr_time - curr_request->arrival_time;
-				curr_request->state = COMPLETE;
-				if(verbose)
-					printf("%d: %d finish %d\n", curr_time, curr_request->request_id, curr_request->turn_around_time);
-				curr_request = NULL;
+	// check whether new requests have arrived
+	Request *request;
+
+	// if yes then add them to IO queue
+	// writes are absorbed by the write-back cache instead as long as it has space
+	while((request = new_request_arrived(curr_time)) != NULL) {
+		arrived_count++;
+		if(write_cache != NULL && request->is_write && !write_cache->is_full()) {
+			if(verbose && !shadow_run)
+				printf("%d: %d cache %d\n", curr_time, first_request_id + request->request_id, request->track_required);
+			request->ack_time = curr_time;
+			request->cached = true;
+			write_cache->absorb(request);
+			if(write_cache->needs_flush()) {
+				flush_writes(write_cache, sched, write_cache->low_watermark, curr_time);
 			}
+		} else {
+			if(verbose && !shadow_run)
+				printf("%d: %d add %d\n", curr_time, first_request_id + request->request_id, request->track_required);
+			sched->add_request(request);
 		}
+		request->state = READY;
+	}
 
+	// let the device serve the requests for this tick
+	device->service(sched);
 
-		// if there is no request going on currently then get new one from IO queue
-		if(curr_request == NULL) {
-			curr_request = sched->get_next_request();
-
-			// if there is request pending in queue then process it.
-			if(curr_request != NULL) {
-				if(print_queue) {
-					printf("\n\n");
-					sched->print_queue();
-					printf("\n\n");
-				}
-				if(verbose) {
-					printf("%d: %d issue %d %d\n", curr_time, curr_request->request_id, curr_request->track_required, curr_head_location);
-				}
-				// calculate accounting for wait time and start time
-				curr_request->start_time = curr_time;
-				curr_request->wait_time = curr_time - curr_request->arrival_time;
-
-				// if we get requests for the same track header is on 
-				// then keep on completing it
-				while(curr_head_location == curr_request->track_required) {
-					// accounting to be performed when request is completed
-					curr_request->end_time = curr_time;
-					curr_request->turn_around_time = curr_time - curr_request->arrival_time;
-					curr_request->state = COMPLETE;
-
-
-					if(verbose)
-						printf("%d: %d finish %d\n", curr_time, curr_request->request_id, curr_request->turn_around_time);
-
-					// again get new request and repeat the process
-					curr_request = sched->get_next_request();
-					if(curr_request == NULL) {
-						break;
-					} else {
-						if(verbose) {
-							printf("%d: %d issue %d %d\n", curr_time, curr_request->request_id, curr_request->track_required, curr_head_location);
-						}
-						curr_request->start_time = curr_time;
-						curr_request->wait_time = curr_time - curr_request->arrival_time;
-					}
-				}
-			}
+	// record the tick, requests which arrived and are neither done, being served nor in cache are queued
+	if(telemetry != NULL) {
+		int queue_depth = arrived_count - completed_count - device->in_service();
+		if(write_cache != NULL) {
+			queue_depth -= write_cache->dirty_count();
 		}
+		telemetry->tick(queue_depth);
+	}
+}
 
-		// finally increment the time
-		curr_time++;
+int next_event_time(Scheduler *sched, Device *device) {
+	/*
+		Function Name: next_event_time
+		Arguments: Scheduler *sched, Device *device
+		Returns: int: earliest tick from current time at which something other than head movement happens
+		Description: finds the next tick at which a request arrives, the device completes a request, the
+			scheduler stops holding requests back or the write-back cache is drained. Ticks before it can
+			be skipped with Device::advance.
+	*/
+	int next = device->next_event();
+	if(sched->next_event() < next) {
+		next = sched->next_event();
 	}
+	if(next_arrival != requests.end() && (*next_arrival)->arrival_time < next) {
+		next = (*next_arrival)->arrival_time;
+	}
+	if(write_cache != NULL && arrived_count == requests.size() && write_cache->dirty_count() > 0) {
+		next = curr_time;
+	}
+	return next < curr_time ? curr_time : next;
+}
 
-	// print the requests and their corresponding information
-	print_requests();
+void end_simulation(Scheduler *sched, Device *device, Summary *summary) {
+	/*
+		Function Name: end_simulation
+		Arguments: Scheduler *sched, Device *device, Summary *summary: filled with the results
+		Returns: void
+		Description: fills in the summary of the finished run and frees its scheduler, device and cache
+	*/
+	// a device which got no requests never ran
+	summary->total_time = requests.size() > 0 ? curr_time-1 : 0;
+	finalize_results(summary);
+	summary->flushes = write_cache != NULL ? write_cache->flushes : 0;
+	device->summarize(summary);
+	// the ssd has no head, so the order of flushed writes does not save any movement
+	summary->writeback_movement = write_cache != NULL && summary->channels == 0 ? write_cache->writeback_movement : 0;
+	summary->saved_movement = 0; // measured by the caller against a run without the cache
+	sched->summarize(summary);
+
+	delete sched;
+	delete device;
+	delete write_cache;
+	write_cache = NULL;
+}
 
-	// print the summary
-	printf("SUM: %d %d %.2lf %.2lf %d\n", curr_time-1, tot_movement, get_avg_turnaround_time(),get_avg_wait_time() , get_max_wait_time());
+Scheduler* create_scheduler(char algo) {
+	/*
+		Function Name: create_scheduler
+		Arguments: char algo: character of the scheduling algorithm
+		Returns: Scheduler*: new scheduler implementing the algorithm, NULL if unknown
+		Description: creates the scheduler for the algorithm specified
+	*/
+	if(algo == 'i') {
+		return new FIFOScheduler();
+	} else if(algo == 'j') {
+		return new SSTFScheduler();
+	} else if(algo == 's') {
+		return new LookScheduler();
+	} else if(algo == 'c') {
+		return new CLookScheduler();
+	} else if(algo == 'f') {
+		return new FLookScheduler();
+	} else if(algo == 'a') {
+		return new AdaptiveScheduler(ADAPTIVE_WINDOW);
+	}
+	return NULL;
 }
 
-bool is_request_active() {
+Device* create_device() {
 	/*
-		Function Name: is_request_active
+		Function Name: create_device
 		Arguments: void
-		Returns: bool
-		Description: checks whether there are any requests in list which are active
+		Returns: Device*: new device as per options specified
+		Description: creates the ssd if it is selected, otherwise the disk
 	*/
+	if(ssd) {
+		return new SSDDevice(ssd_channels, ssd_read_time, ssd_write_time, ssd_channel_aware);
+	}
+	return new DiskDevice();
+}
 
-	// iterate through the list to find atleast one request that is active
-	// active means either CREATED or in queue i.e. READY or 
-	// currently being processed i.e. RUNNING
-	std::list<Request*>::iterator it;
-	for (it = requests.begin(); it != requests.end(); ++it){
-		// if one such request found then return true
-    	if((*it)->state == CREATED || (*it)->state == READY || (*it)->state == RUNNING)
-    		return true;
+Request* fetch_request(Scheduler *sched) {
+	/*
+		Function Name: fetch_request
+		Arguments: Scheduler *sched
+		Returns: Request*: next request from IO queue, NULL if queue is empty
+		Description: gives the next request from the IO queue. Once all requests have arrived
+			and the queue is drained, what is left in the write-back cache is flushed into it.
+	*/
+	Request *request = sched->get_next_request();
+	if(request == NULL && write_cache != NULL && arrived_count == requests.size() && write_cache->dirty_count() > 0) {
+		flush_writes(write_cache, sched, 0, curr_time);
+		request = sched->get_next_request();
 	}
+	return request;
+}
 
-	// else there is no such request
-	return false;
+void issue_request(Request *request, int position) {
+	/*
+		Function Name: issue_request
+		Arguments: Request *request: request being issued, int position: head location or channel serving it
+		Returns: void
+		Description: performs the accounting when the request is issued to the device
+	*/
+	if(verbose && !shadow_run) {
+		printf("%d: %d issue %d %d\n", curr_time, first_request_id + request->request_id, request->track_required, position);
+	}
+	// calculate accounting for wait time and start time
+	request->start_time = curr_time;
+	request->wait_time = curr_time - request->arrival_time;
 }
 
+void finish_request(Request *request, int curr_time) {
+	/*
+		Function Name: finish_request
+		Arguments: Request *request: request which is completed, int curr_time
+		Returns: void
+		Description: performs the accounting when the request is completed
+	*/
+	request->end_time = curr_time;
+	request->turn_around_time = curr_time - request->arrival_time;
+	request->state = COMPLETE;
+	completed_count++;
+	if(telemetry != NULL) {
+		telemetry->completed(request);
+	}
+
+	// writes not absorbed by the cache are acknowledged only when they reach the disk
+	if(request->ack_time < 0) {
+		request->ack_time = curr_time;
+	}
+	if(request->cached && write_cache != NULL) {
+		write_cache->writeback_movement += request->seek_distance;
+	}
+	if(checkpoint_file != NULL && !shadow_run) {
+		log_completion(request);
+	}
 
-void print_requests() {
+	if(verbose && !shadow_run)
+		printf("%d: %d finish %d\n", curr_time, first_request_id + request->request_id, request->turn_around_time);
+}
+
+void flush_writes(WriteBackCache *write_cache, Scheduler *sched, int target, int curr_time) {
 	/*
-		Function Name: print_requests
-		Arguments: void
+		Function Name: flush_writes
+		Arguments: WriteBackCache *write_cache, Scheduler *sched, int target: dirty writes to be left in cache, int curr_time
 		Returns: void
-		Description: prints the request info required at the end
+		Description: flushes a sorted batch of writes from the cache into the IO queue
 	*/
+	std::list<Request*> batch = write_cache->flush(target);
 	std::list<Request*>::iterator it;
-	for (it = requests.begin(); it != requests.end(); ++it){
-    	(*it)->print_request(); // calls the print_requests function of Request class
+	for(it = batch.begin(); it != batch.end(); ++it) {
+		if(verbose && !shadow_run)
+			printf("%d: %d flush %d\n", curr_time, first_request_id + (*it)->request_id, (*it)->track_required);
+		sched->add_request(*it);
 	}
 }
 
+bool is_request_active() {
+	/*
+		Function Name: is_request_active
+		Arguments: void
+		Returns: bool
+		Description: checks whether there are any requests in list which are active
+	*/
+
+	// active means either CREATED or in queue i.e. READY or
+	// currently being processed i.e. RUNNING, so all but the completed ones
+	return completed_count < requests.size();
+}
+
 
 Request* new_request_arrived(int curr_time) {
 	/*
 		Function Name: new_request_arrived
 		Arguments: int curr_time
-		Returns: Request*: new request arrived at this time else give NULL
-		Description: gives the request that arrived at this time else returns NULL
+		Returns: Request*: next request arrived at this time else give NULL
+		Description: gives the next request that arrived by this time else returns NULL
 	*/
-	std::list<Request*>::iterator it;
-	for (it = requests.begin(); it != requests.end(); ++it){	
-		// if request's arrival time is current time then return it.
-    	if((*it)->arrival_time == curr_time) {
-    		return (*it);
-    	}
-    	if((*it)->arrival_time > curr_time) {
-    		break;
-    	}
-	}
-	// else return NULL
+	// requests are in arrival order so only the request at the cursor needs to be checked
+	if(next_arrival != requests.end() && (*next_arrival)->arrival_time <= curr_time) {
+		return *(next_arrival++);
+	}
 	return NULL;
 }
 
 
-double get_avg_turnaround_time() {
+void finalize_results(Summary *summary) {
 	/*
-		Function Name: get_avg_turnaround_time
-		Arguments: void
-		Returns: double: average turnaround time of all requests
-		Description: calculates average turnaround time of all requests
+		Function Name: finalize_results
+		Arguments: Summary *summary: filled with the averages and maximums over requests
+		Returns: void
+		Description: computes all the per request aggregates of the summary in a single pass over
+			the requests, writing the result of every request on the way if a writer is set. Warmup
+			requests arriving before the replay window only bring the queue to its state at the start
+			of the window and are left out.
 	*/
-	double turn_around_time = 0;
-	std::list<Request*>::iterator it;
-	for (it = requests.begin(); it != requests.end(); ++it){
-    	turn_around_time += (*it)->turn_around_time;
-	}
-	turn_around_time = turn_around_time/requests.size();
-	return turn_around_time;
-}
+	double turn_around_time = 0, wait_time = 0, read_latency = 0, write_ack_latency = 0, transfer_time = 0;
+	int max_wait_time = 0, reads = 0, writes = 0, counted = 0;
+	long long sectors = 0;
 
-double get_avg_wait_time() {
-	/*
-		Function Name: get_avg_wait_time
-		Arguments: void
-		Returns: double: average wait time of all requests
-		Description: calculates average wait time of all requests
-	*/
-	double wait_time = 0;
 	std::list<Request*>::iterator it;
 	for (it = requests.begin(); it != requests.end(); ++it){
-    	wait_time += (*it)->wait_time;
+		Request *request = *it;
+		if(request->arrival_time < replay_from) {
+			continue;
+		}
+		counted++;
+		turn_around_time += request->turn_around_time;
+		wait_time += request->wait_time;
+		if(request->wait_time > max_wait_time) {
+			max_wait_time = request->wait_time;
+		}
+		transfer_time += request->transfer_time;
+		sectors += request->size;
+		if(request->is_write) {
+			write_ack_latency += request->ack_time - request->arrival_time;
+			writes++;
+		} else {
+			read_latency += request->turn_around_time;
+			reads++;
+		}
+		if(result_writer != NULL) {
+			result_writer->write(request);
+		}
 	}
-	wait_time = wait_time/requests.size();
-	return wait_time;
+
+	int count = counted > 0 ? counted : 1;
+	summary->requests = counted;
+	summary->avg_turnaround_time = turn_around_time/count;
+	summary->avg_wait_time = wait_time/count;
+	summary->max_wait_time = max_wait_time;
+	summary->has_writes = writes > 0;
+	summary->avg_read_latency = reads > 0 ? read_latency/reads : 0;
+	summary->avg_write_ack_latency = writes > 0 ? write_ack_latency/writes : 0;
+	summary->bytes = sectors * SECTOR_SIZE;
+	summary->avg_transfer_time = transfer_time/count;
 }
 
-int get_max_wait_time() {
+
+int shadow_movement(char algo, bool cache, bool anticipation) {
 	/*
-		Function Name: get_max_wait_time
-		Arguments: void
-		Returns: int: maximum time a request had to wait
-		Description: finds out the maximum time a request had to wait
+		Function Name: shadow_movement
+		Arguments: char algo: scheduling algorithm, bool cache, bool anticipation: whether the write-back cache
+			and anticipation are kept
+		Returns: int: head movement of the run
+		Description: simulates copies of the requests in requests list once more, silently and with the cache or
+			anticipation turned off, so that the movement they save is measured rather than estimated. It has to be called
+			before the requests are simulated, and leaves them and the writers of the real run untouched.
 	*/
-	int max_wait_time = 0;
+	std::list<Request*> original;
+	original.swap(requests);
 	std::list<Request*>::iterator it;
-	for (it = requests.begin(); it != requests.end(); ++it){
-    	if((*it)->wait_time > max_wait_time) {
-    		max_wait_time = (*it)->wait_time;
-    	}
+	for(it = original.begin(); it != original.end(); ++it) {
+		requests.push_back(new Request(**it));
 	}
-	return max_wait_time;
-}
\ No newline at end of file
+	Telemetry *real_telemetry = telemetry;
+	ResultWriter *real_result_writer = result_writer;
+	telemetry = NULL;
+	result_writer = NULL;
+	shadow_run = true;
+	shadow_cache = cache;
+	shadow_anticipation = anticipation;
+
+	Summary summary;
+	run_simulation(algo, &summary);
+
+	shadow_run = false;
+	telemetry = real_telemetry;
+	result_writer = real_result_writer;
+	for(it = requests.begin(); it != requests.end(); ++it) {
+		delete *it;
+	}
+	requests.swap(original);
+	return summary.tot_movement;
+}
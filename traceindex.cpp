@@ -0,0 +1,95 @@
+/*
+	Module Name: traceindex.cpp
+	Description: Builds the index of a trace file which lets a window of the trace be read without parsing
+		everything before it. The index is stored beside the trace as <trace>.idx and rebuilt when the
+		trace changes.
+*/
+#include <stdio.h>
+#include <fstream>
+#include <string>
+#include <string.h>
+#include <sys/stat.h>
+#include "data_structures.h"
+
+
+/*************************** function declarations ***************************/
+void build_trace_index(char *filename, TraceIndex *index);
+
+
+bool open_trace_index(char *filename, TraceIndex *index) {
+	/*
+		Function Name: open_trace_index
+		Arguments: char *filename: path to trace, TraceIndex *index: filled with the index of the trace
+		Returns: bool: false if trace cannot be read
+		Description: loads the index stored beside the trace, or builds and stores it if there is none
+			or it was built from an older version of the trace
+	*/
+	struct stat trace_stat;
+	if(stat(filename, &trace_stat) != 0) {
+		return false;
+	}
+	std::string index_file = std::string(filename) + ".idx";
+
+	FILE *file = fopen(index_file.c_str(), "rb");
+	if(file != NULL) {
+		bool ok = index->load(file);
+		fclose(file);
+		if(ok && index->interval == TRACE_INDEX_INTERVAL && index->trace_size == (long long)trace_stat.st_size
+			&& index->trace_mtime == (long long)trace_stat.st_mtime) {
+			return true;
+		}
+	}
+
+	*index = TraceIndex();
+	index->trace_size = trace_stat.st_size;
+	index->trace_mtime = trace_stat.st_mtime;
+	build_trace_index(filename, index);
+
+	// the index is only a cache, a trace in a read only directory is still replayed
+	std::string temp_file = index_file + ".tmp";
+	file = fopen(temp_file.c_str(), "wb");
+	if(file != NULL) {
+		index->save(file);
+		if(fclose(file) == 0) {
+			rename(temp_file.c_str(), index_file.c_str());
+		} else {
+			remove(temp_file.c_str());
+		}
+	}
+	return true;
+}
+
+
+void build_trace_index(char *filename, TraceIndex *index) {
+	/*
+		Function Name: build_trace_index
+		Arguments: char *filename: path to trace, TraceIndex *index: entries are appended to it
+		Returns: void
+		Description: reads the trace once, noting the offset and id of the first request of every interval
+			and the number of requests. Lines are skipped exactly as readInput skips them so the ids agree.
+	*/
+	char *line = new char[100]; // buffer
+	int arrival_time;
+	long long offset = 0; // offset of line being read
+	int curr_req_id = 0;
+	std::fstream file;
+
+	file.open(filename, std::ios_base::in | std::ios_base::binary);
+	while(file.getline(line, 100)) {
+		long long line_offset = offset;
+		offset += file.gcount();
+		if(strlen(line) == 0 || line[0] == '#') {
+			continue;
+		}
+		sscanf(line, "%d", &arrival_time);
+
+		// intervals without any arrival point to the next request which arrives
+		while((long long)index->offsets.size() * index->interval <= arrival_time) {
+			index->offsets.push_back(line_offset);
+			index->ids.push_back(curr_req_id);
+		}
+		curr_req_id++;
+	}
+	index->request_count = curr_req_id;
+	delete[] line;
+}